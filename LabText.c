@@ -6,10 +6,47 @@
 
 #include <math.h>
 
-//! @todo replace Assert with custom error reporting mechanism
+// Assert guards against programming errors only, such as null or inverted
+// ranges. Malformed input is reported through the tsStatus out parameter of
+// the Checked functions, and located on demand with tsLocate.
 #include <assert.h>
 #define Assert assert
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define TS_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+    static inline int tsPopCount32(uint32_t v) { return (int) __popcnt(v); }
+    static inline int tsCountTrailingZeros32(uint32_t v) { unsigned long i; _BitScanForward(&i, v); return (int) i; }
+    static inline int tsHighestBit32(uint32_t v) { unsigned long i; _BitScanReverse(&i, v); return (int) i; }
+#elif defined(__GNUC__) || defined(__clang__)
+    static inline int tsPopCount32(uint32_t v) { return __builtin_popcount(v); }
+    static inline int tsCountTrailingZeros32(uint32_t v) { return __builtin_ctz(v); }
+    static inline int tsHighestBit32(uint32_t v) { return 31 - __builtin_clz(v); }
+#else
+    static inline int tsCountTrailingZeros32(uint32_t v)
+    {
+        int i = 0;
+        while (!(v & 1)) { v >>= 1; ++i; }
+        return i;
+    }
+    static inline int tsHighestBit32(uint32_t v)
+    {
+        int i = 0;
+        while (v >>= 1) ++i;
+        return i;
+    }
+    static inline int tsPopCount32(uint32_t v)
+    {
+        v = v - ((v >> 1) & 0x55555555u);
+        v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+        return (int) ((((v + (v >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+    }
+#endif
+
 //----------------------------------------------------------------------------
 
 const char* tsScanForQuote(
@@ -38,7 +75,7 @@ const char* tsScanForWhiteSpace(
     while (pCurr < pEnd && !tsIsWhiteSpace(*pCurr))
         ++pCurr;
 
-    return pCurr+1;
+    return pCurr;
 }
 
 const char* tsScanForNonWhiteSpace(
@@ -63,6 +100,72 @@ const char* tsScanBackwardsForWhiteSpace(
     return pCurr;
 }
 
+// The half open backwards scanners search [pStart, pCurr) from the end, and
+// return the position just past the match, or pStart if there is none, so the
+// result is always a boundary within the range. 32 bytes are tested per step.
+
+#ifdef TS_SSE2
+
+static inline uint32_t tsBackwardsMask(const char* p, __m128i a, __m128i b, __m128i c, __m128i d)
+{
+    __m128i lo = _mm_loadu_si128((const __m128i*) p);
+    __m128i hi = _mm_loadu_si128((const __m128i*) (p + 16));
+    __m128i mlo = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(lo, a), _mm_cmpeq_epi8(lo, b)),
+                               _mm_or_si128(_mm_cmpeq_epi8(lo, c), _mm_cmpeq_epi8(lo, d)));
+    __m128i mhi = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(hi, a), _mm_cmpeq_epi8(hi, b)),
+                               _mm_or_si128(_mm_cmpeq_epi8(hi, c), _mm_cmpeq_epi8(hi, d)));
+    return (uint32_t) _mm_movemask_epi8(mlo) | (uint32_t) _mm_movemask_epi8(mhi) << 16;
+}
+
+// Any of up to four bytes; repeat one to search for fewer.
+static const char* tsScanBackwardsForAny(const char* pCurr, const char* pStart, char a, char b, char c, char d)
+{
+    const __m128i va = _mm_set1_epi8(a), vb = _mm_set1_epi8(b), vc = _mm_set1_epi8(c), vd = _mm_set1_epi8(d);
+    while (pCurr - pStart >= 32)
+    {
+        uint32_t mask = tsBackwardsMask(pCurr - 32, va, vb, vc, vd);
+        if (mask)
+            return pCurr - 32 + tsHighestBit32(mask) + 1;
+        pCurr -= 32;
+    }
+    while (pCurr > pStart && pCurr[-1] != a && pCurr[-1] != b && pCurr[-1] != c && pCurr[-1] != d)
+        --pCurr;
+    return pCurr;
+}
+
+#else
+
+static const char* tsScanBackwardsForAny(const char* pCurr, const char* pStart, char a, char b, char c, char d)
+{
+    while (pCurr > pStart && pCurr[-1] != a && pCurr[-1] != b && pCurr[-1] != c && pCurr[-1] != d)
+        --pCurr;
+    return pCurr;
+}
+
+#endif
+
+const char* tsScanBackwardsToWhiteSpace(
+    const char* pCurr, const char* pStart)
+{
+    Assert(pCurr && pStart && pStart <= pCurr);
+    return tsScanBackwardsForAny(pCurr, pStart, ' ', '\t', '\r', '\n');
+}
+
+const char* tsScanBackwardsToCharacter(
+    const char* pCurr, const char* pStart,
+    char delim)
+{
+    Assert(pCurr && pStart && pStart <= pCurr);
+    return tsScanBackwardsForAny(pCurr, pStart, delim, delim, delim, delim);
+}
+
+const char* tsScanBackwardsForBeginningOfLine(
+    const char* pCurr, const char* pStart)
+{
+    Assert(pCurr && pStart && pStart <= pCurr);
+    return tsScanBackwardsForAny(pCurr, pStart, '\r', '\n', '\r', '\n');
+}
+
 const char* tsScanForTrailingNonWhiteSpace(
     const char* pCurr, const char* pEnd)
 {
@@ -134,14 +237,14 @@ const char* tsScanForEndOfLine(
         if (*pCurr == '\r')
         {
             ++pCurr;
-            if (*pCurr == '\n')
+            if (pCurr < pEnd && *pCurr == '\n')
                 ++pCurr;
             break;
         }
         if (*pCurr == '\n')
         {
             ++pCurr;
-            if (*pCurr == '\r')
+            if (pCurr < pEnd && *pCurr == '\r')
                 ++pCurr;
             break;
         }
@@ -156,7 +259,7 @@ const char* tsScanForLastCharacterOnLine(
 {
     while (pCurr < pEnd)
     {
-        if (pCurr[1] == '\r' || pCurr[1] == '\n' || pCurr[1] == '\0')
+        if (pCurr + 1 == pEnd || pCurr[1] == '\r' || pCurr[1] == '\n' || pCurr[1] == '\0')
         {
             break;
         }
@@ -173,10 +276,13 @@ const char* tsScanForBeginningOfNextLine(
     return (tsScanForNonWhiteSpace(pCurr, pEnd));
 }
 
-const char* tsScanPastCPPComments(
-    const char* pCurr, const char* pEnd)
+const char* tsScanPastCPPCommentsChecked(
+    const char* pCurr, const char* pEnd,
+    tsStatus* status)
 {
-    if (*pCurr == '/')
+    *status = tsOk;
+
+    if (pCurr + 1 < pEnd && *pCurr == '/')
     {
         if (pCurr[1] == '/')
         {
@@ -185,24 +291,31 @@ const char* tsScanPastCPPComments(
         else if (pCurr[1] == '*')
         {
             pCurr = &pCurr[2];
-            while (pCurr < pEnd)
+            while (pCurr + 1 < pEnd)
             {
                 if (pCurr[0] == '*' && pCurr[1] == '/')
-                {
-                    pCurr = &pCurr[2];
-                    break;
-                }
+                    return &pCurr[2];
 
                 ++pCurr;
             }
+            *status = tsErrorUnterminatedComment;
+            pCurr = pEnd;
         }
     }
 
     return pCurr;
 }
 
-const char* tsSkipCommentsAndWhitespace(
-    const char* curr, const char*const end)
+const char* tsScanPastCPPComments(
+    const char* pCurr, const char* pEnd)
+{
+    tsStatus status;
+    return tsScanPastCPPCommentsChecked(pCurr, pEnd, &status);
+}
+
+const char* tsSkipCommentsAndWhitespaceChecked(
+    const char* curr, const char*const end,
+    tsStatus* status)
 {
     bool moved = true;
     while (moved)
@@ -210,7 +323,10 @@ const char* tsSkipCommentsAndWhitespace(
         const char* past = tsScanForNonWhiteSpace(curr, end);
         curr = past;
 
-        past = tsScanPastCPPComments(curr, end);
+        past = tsScanPastCPPCommentsChecked(curr, end, status);
+        if (*status != tsOk)
+            return past;
+
         moved = past != curr;
         curr = past;
     }
@@ -218,42 +334,47 @@ const char* tsSkipCommentsAndWhitespace(
     return tsScanForNonWhiteSpace(curr, end);
 }
 
-const char* tsGetToken(
+const char* tsSkipCommentsAndWhitespace(
+    const char* curr, const char*const end)
+{
+    tsStatus status;
+    return tsSkipCommentsAndWhitespaceChecked(curr, end, &status);
+}
+
+const char* tszGetToken(
     const char* pCurr, const char* pEnd,
     char delim,
-    const char** resultStringBegin, uint32_t* stringLength)
+    const char** resultStringBegin, size_t* stringLength)
 {
     Assert(pCurr && pEnd);
 
     pCurr = tsScanForNonWhiteSpace(pCurr, pEnd);
     *resultStringBegin = pCurr;
     const char* pStringEnd = tsScanForCharacter(pCurr, pEnd, delim);
-    *stringLength = (uint32_t)(pStringEnd - *resultStringBegin);
+    *stringLength = (size_t)(pStringEnd - *resultStringBegin);
     return pStringEnd;
 }
 
-const char* tsGetTokenWSDelimited(
+const char* tszGetTokenWSDelimited(
     const char* pCurr, const char* pEnd,
-    const char** resultStringBegin, uint32_t* stringLength)
+    const char** resultStringBegin, size_t* stringLength)
 {
     pCurr = tsScanForNonWhiteSpace(pCurr, pEnd);
     *resultStringBegin = pCurr;
     const char* pStringEnd = tsScanForWhiteSpace(pCurr, pEnd);
-    *stringLength = (uint32_t)(pStringEnd - *resultStringBegin);
+    *stringLength = (size_t)(pStringEnd - *resultStringBegin);
     return pStringEnd;
 }
 
-const char* tsGetTokenAlphaNumericExt(
+const char* tszGetTokenAlphaNumericExt(
     const char* pCurr, const char* pEnd,
     const char* ext_,
-    const char** resultStringBegin, uint32_t* stringLength)
+    const char** resultStringBegin, size_t* stringLength)
 {
     Assert(pCurr && pEnd);
 
     pCurr = tsScanForNonWhiteSpace(pCurr, pEnd);
     *resultStringBegin = pCurr;
-    *stringLength = 0;
-
     while (pCurr < pEnd)
     {
         char test = pCurr[0];
@@ -270,23 +391,21 @@ const char* tsGetTokenAlphaNumericExt(
             break;
 
         ++pCurr;
-        *stringLength += 1;
     }
 
+    *stringLength = (size_t)(pCurr - *resultStringBegin);
     return pCurr;
 }
 
-const char* tsGetTokenExt(
+const char* tszGetTokenExt(
     const char* pCurr, const char* pEnd,
     const char* ext_,
-    const char** resultStringBegin, uint32_t* stringLength)
+    const char** resultStringBegin, size_t* stringLength)
 {
     Assert(pCurr && pEnd);
 
     pCurr = tsScanForNonWhiteSpace(pCurr, pEnd);
     *resultStringBegin = pCurr;
-    *stringLength = 0;
-
     while (pCurr < pEnd)
     {
         char test = pCurr[0];
@@ -303,22 +422,20 @@ const char* tsGetTokenExt(
             break;
 
         ++pCurr;
-        *stringLength += 1;
     }
 
+    *stringLength = (size_t)(pCurr - *resultStringBegin);
     return pCurr;
 }
 
-const char* tsGetTokenAlphaNumeric(
+const char* tszGetTokenAlphaNumeric(
     const char* pCurr, const char* pEnd,
-    const char** resultStringBegin, uint32_t* stringLength)
+    const char** resultStringBegin, size_t* stringLength)
 {
     Assert(pCurr && pEnd);
 
     pCurr = tsScanForNonWhiteSpace(pCurr, pEnd);
     *resultStringBegin = pCurr;
-    *stringLength = 0;
-
     while (pCurr < pEnd)
     {
         char test = pCurr[0];
@@ -332,23 +449,21 @@ const char* tsGetTokenAlphaNumeric(
             break;
 
         ++pCurr;
-        *stringLength += 1;
     }
 
+    *stringLength = (size_t)(pCurr - *resultStringBegin);
     return pCurr;
 }
 
-const char* tsGetNameSpacedTokenAlphaNumeric(
+const char* tszGetNameSpacedTokenAlphaNumeric(
     const char* pCurr, const char* pEnd,
     char namespaceChar,
-    const char** resultStringBegin, uint32_t* stringLength)
+    const char** resultStringBegin, size_t* stringLength)
 {
     Assert(pCurr && pEnd);
 
     pCurr = tsScanForNonWhiteSpace(pCurr, pEnd);
     *resultStringBegin = pCurr;
-    *stringLength = 0;
-
     while (pCurr < pEnd)
     {
         char test = pCurr[0];
@@ -363,141 +478,319 @@ const char* tsGetNameSpacedTokenAlphaNumeric(
             break;
 
         ++pCurr;
-        *stringLength += 1;
     }
 
+    *stringLength = (size_t)(pCurr - *resultStringBegin);
     return pCurr;
 }
 
-const char* tsGetString(
+const char* tszGetStringQuotedChecked(
     const char* pCurr, const char* pEnd,
+    char delim,
     bool recognizeEscapes,
-    const char** resultStringBegin, uint32_t* stringLength)
+    const char** resultStringBegin, size_t* stringLength,
+    tsStatus* status)
 {
     Assert(pCurr && pEnd && pEnd >= pCurr);
 
-    pCurr = tsScanForQuote(pCurr, pEnd, '\"', recognizeEscapes);
+    pCurr = tsScanForQuote(pCurr, pEnd, delim, recognizeEscapes);
 
     if (pCurr < pEnd)
     {
         ++pCurr;    // skip past quote
         *resultStringBegin = pCurr;
 
-        pCurr = tsScanForQuote(pCurr, pEnd, '\"', recognizeEscapes);
+        pCurr = tsScanForQuote(pCurr, pEnd, delim, recognizeEscapes);
+
+        // an escape as the final character may step one past pEnd
+        if (pCurr > pEnd)
+            pCurr = pEnd;
 
-        if (pCurr <= pEnd)
-            *stringLength = (uint32_t)(pCurr - *resultStringBegin);
-        else
-            *stringLength = 0;
+        *stringLength = (size_t)(pCurr - *resultStringBegin);
 
-        ++pCurr;    // point past closing quote
+        if (pCurr < pEnd)
+        {
+            *status = tsOk;
+            ++pCurr;    // point past closing quote
+        }
+        else
+            *status = tsErrorUnterminatedString;
     }
     else
+    {
+        *resultStringBegin = pEnd;
         *stringLength = 0;
+        *status = tsErrorExpectedQuote;
+        pCurr = pEnd;
+    }
 
     return pCurr;
 }
 
-const char* tsGetStringQuoted(
-                        const char* pCurr, const char* pEnd,
-                        char delim,
-                        bool recognizeEscapes,
-                        const char** resultStringBegin, uint32_t* stringLength)
+const char* tszGetStringChecked(
+    const char* pCurr, const char* pEnd,
+    bool recognizeEscapes,
+    const char** resultStringBegin, size_t* stringLength,
+    tsStatus* status)
 {
-    Assert(pCurr && pEnd && pEnd >= pCurr);
+    return tszGetStringQuotedChecked(pCurr, pEnd, '\"', recognizeEscapes, resultStringBegin, stringLength, status);
+}
 
-    pCurr = tsScanForQuote(pCurr, pEnd, delim, recognizeEscapes);
+const char* tszGetString(
+    const char* pCurr, const char* pEnd,
+    bool recognizeEscapes,
+    const char** resultStringBegin, size_t* stringLength)
+{
+    tsStatus status;
+    return tszGetStringQuotedChecked(pCurr, pEnd, '\"', recognizeEscapes, resultStringBegin, stringLength, &status);
+}
 
-    if (pCurr < pEnd)
-    {
-        ++pCurr;    // skip past quote
-        *resultStringBegin = pCurr;
+const char* tszGetStringQuoted(
+    const char* pCurr, const char* pEnd,
+    char delim,
+    bool recognizeEscapes,
+    const char** resultStringBegin, size_t* stringLength)
+{
+    tsStatus status;
+    return tszGetStringQuotedChecked(pCurr, pEnd, delim, recognizeEscapes, resultStringBegin, stringLength, &status);
+}
 
-        pCurr = tsScanForQuote(pCurr, pEnd, delim, recognizeEscapes);
+// 32 bit length interface, retained for existing callers. Lengths of 4GiB
+// or more are truncated; use the tsz functions for large inputs.
 
-        if (pCurr <= pEnd)
-            *stringLength = (uint32_t)(pCurr - *resultStringBegin);
-        else
-            *stringLength = 0;
+const char* tsGetToken(
+    const char* pCurr, const char* pEnd,
+    char delim,
+    const char** resultStringBegin, uint32_t* stringLength)
+{
+    size_t sz;
+    const char* next = tszGetToken(pCurr, pEnd, delim, resultStringBegin, &sz);
+    *stringLength = (uint32_t) sz;
+    return next;
+}
 
-        ++pCurr;    // point past closing quote
-    }
-    else
-        *stringLength = 0;
+const char* tsGetTokenWSDelimited(
+    const char* pCurr, const char* pEnd,
+    const char** resultStringBegin, uint32_t* stringLength)
+{
+    size_t sz;
+    const char* next = tszGetTokenWSDelimited(pCurr, pEnd, resultStringBegin, &sz);
+    *stringLength = (uint32_t) sz;
+    return next;
+}
 
-    return pCurr;
+const char* tsGetTokenAlphaNumeric(
+    const char* pCurr, const char* pEnd,
+    const char** resultStringBegin, uint32_t* stringLength)
+{
+    size_t sz;
+    const char* next = tszGetTokenAlphaNumeric(pCurr, pEnd, resultStringBegin, &sz);
+    *stringLength = (uint32_t) sz;
+    return next;
+}
+
+const char* tsGetTokenAlphaNumericExt(
+    const char* pCurr, const char* pEnd,
+    const char* ext,
+    const char** resultStringBegin, uint32_t* stringLength)
+{
+    size_t sz;
+    const char* next = tszGetTokenAlphaNumericExt(pCurr, pEnd, ext, resultStringBegin, &sz);
+    *stringLength = (uint32_t) sz;
+    return next;
+}
+
+const char* tsGetTokenExt(
+    const char* pCurr, const char* pEnd,
+    const char* ext,
+    const char** resultStringBegin, uint32_t* stringLength)
+{
+    size_t sz;
+    const char* next = tszGetTokenExt(pCurr, pEnd, ext, resultStringBegin, &sz);
+    *stringLength = (uint32_t) sz;
+    return next;
+}
+
+const char* tsGetNameSpacedTokenAlphaNumeric(
+    const char* pCurr, const char* pEnd,
+    char namespaceChar,
+    const char** resultStringBegin, uint32_t* stringLength)
+{
+    size_t sz;
+    const char* next = tszGetNameSpacedTokenAlphaNumeric(pCurr, pEnd, namespaceChar, resultStringBegin, &sz);
+    *stringLength = (uint32_t) sz;
+    return next;
+}
+
+const char* tsGetString(
+    const char* pCurr, const char* pEnd,
+    bool recognizeEscapes,
+    const char** resultStringBegin, uint32_t* stringLength)
+{
+    size_t sz;
+    const char* next = tszGetString(pCurr, pEnd, recognizeEscapes, resultStringBegin, &sz);
+    *stringLength = (uint32_t) sz;
+    return next;
+}
+
+const char* tsGetStringQuoted(
+    const char* pCurr, const char* pEnd,
+    char delim,
+    bool recognizeEscapes,
+    const char** resultStringBegin, uint32_t* stringLength)
+{
+    size_t sz;
+    const char* next = tszGetStringQuoted(pCurr, pEnd, delim, recognizeEscapes, resultStringBegin, &sz);
+    *stringLength = (uint32_t) sz;
+    return next;
+}
+
+const char* tsGetStringChecked(
+    const char* pCurr, const char* pEnd,
+    bool recognizeEscapes,
+    const char** resultStringBegin, uint32_t* stringLength,
+    tsStatus* status)
+{
+    size_t sz;
+    const char* next = tszGetStringChecked(pCurr, pEnd, recognizeEscapes, resultStringBegin, &sz, status);
+    *stringLength = (uint32_t) sz;
+    return next;
+}
+
+const char* tsGetStringQuotedChecked(
+    const char* pCurr, const char* pEnd,
+    char delim,
+    bool recognizeEscapes,
+    const char** resultStringBegin, uint32_t* stringLength,
+    tsStatus* status)
+{
+    size_t sz;
+    const char* next = tszGetStringQuotedChecked(pCurr, pEnd, delim, recognizeEscapes, resultStringBegin, &sz, status);
+    *stringLength = (uint32_t) sz;
+    return next;
 }
 
 // Match pExpect. If pExect is found in the input stream, return pointing
 // to the character that follows, otherwise return the start of the input stream
 
-const char* tsExpect(
+const char* tsExpectChecked(
     const char* pCurr, const char*const pEnd,
-    const char* pExpect)
+    const char* pExpect,
+    tsStatus* status)
 {
     const char* pScan = pCurr;
     while (pScan != pEnd && *pScan == *pExpect && *pExpect != '\0') {
         ++pScan;
         ++pExpect;
     }
-    return (*pExpect == '\0' ? pScan : pCurr);
+    if (*pExpect == '\0') {
+        *status = tsOk;
+        return pScan;
+    }
+    *status = tsErrorUnexpectedInput;
+    return pCurr;
 }
 
-const char* tsGetInt16(
+const char* tsExpect(
+    const char* pCurr, const char*const pEnd,
+    const char* pExpect)
+{
+    tsStatus status;
+    return tsExpectChecked(pCurr, pEnd, pExpect, &status);
+}
+
+const char* tsGetInt16Checked(
     const char* pCurr, const char* pEnd,
-    int16_t* result)
+    int16_t* result,
+    tsStatus* status)
 {
     int32_t longresult;
-    const char* retval = tsGetInt32(pCurr, pEnd, &longresult);
+    const char* retval = tsGetInt32Checked(pCurr, pEnd, &longresult, status);
+    if (*status == tsOk && (longresult < INT16_MIN || longresult > INT16_MAX))
+        *status = tsErrorOverflow;
     *result = (int16_t) longresult;
     return retval;
 }
 
-const char* tsGetInt32(
+const char* tsGetInt16(
     const char* pCurr, const char* pEnd,
-    int32_t* result)
+    int16_t* result)
+{
+    tsStatus status;
+    return tsGetInt16Checked(pCurr, pEnd, result, &status);
+}
+
+const char* tsGetInt32Checked(
+    const char* pCurr, const char* pEnd,
+    int32_t* result,
+    tsStatus* status)
 {
     pCurr = tsScanForNonWhiteSpace(pCurr, pEnd);
 
-    int ret = 0;
+    uint64_t ret = 0;
+    bool overflow = false;
 
     bool signFlip = false;
 
-    if (*pCurr == '+')
-    {
-        ++pCurr;
-    }
-    else if (*pCurr == '-')
+    if (pCurr < pEnd)
     {
-        ++pCurr;
-        signFlip = true;
+        if (*pCurr == '+')
+        {
+            ++pCurr;
+        }
+        else if (*pCurr == '-')
+        {
+            ++pCurr;
+            signFlip = true;
+        }
     }
 
+    const char* pDigits = pCurr;
+    const uint64_t limit = signFlip ? (uint64_t) INT32_MAX + 1 : (uint64_t) INT32_MAX;
+
     while (pCurr < pEnd)
     {
         if (!tsIsNumeric(*pCurr))
         {
             break;
         }
-        ret = ret * 10 + *pCurr - '0';
+        ret = ret * 10 + (uint64_t)(*pCurr - '0');
+        overflow |= ret > limit;
         ++pCurr;
     }
 
+    if (pCurr == pDigits)
+        *status = pCurr < pEnd ? tsErrorExpectedNumber : tsErrorEndOfInput;
+    else
+        *status = overflow ? tsErrorOverflow : tsOk;
+
     if (signFlip)
     {
-        ret = -ret;
+        ret = (uint64_t) 0 - ret;
     }
-    *result = ret;
+    *result = (int32_t) (uint32_t) ret;
     return pCurr;
 }
 
-const char* tsGetUInt32(
+const char* tsGetInt32(
     const char* pCurr, const char* pEnd,
-    uint32_t* result)
+    int32_t* result)
+{
+    tsStatus status;
+    return tsGetInt32Checked(pCurr, pEnd, result, &status);
+}
+
+const char* tsGetUInt32Checked(
+    const char* pCurr, const char* pEnd,
+    uint32_t* result,
+    tsStatus* status)
 {
     pCurr = tsScanForNonWhiteSpace(pCurr, pEnd);
 
-    uint32_t ret = 0;
+    uint64_t ret = 0;
+    bool overflow = false;
+
+    const char* pDigits = pCurr;
 
     while (pCurr < pEnd)
     {
@@ -505,10 +798,41 @@ const char* tsGetUInt32(
         {
             break;
         }
-        ret = ret * 10 + *pCurr - '0';
+        ret = ret * 10 + (uint64_t)(*pCurr - '0');
+        overflow |= ret > UINT32_MAX;
         ++pCurr;
     }
-    *result = ret;
+
+    if (pCurr == pDigits)
+        *status = pCurr < pEnd ? tsErrorExpectedNumber : tsErrorEndOfInput;
+    else
+        *status = overflow ? tsErrorOverflow : tsOk;
+
+    *result = (uint32_t) ret;
+    return pCurr;
+}
+
+const char* tsGetUInt32(
+    const char* pCurr, const char* pEnd,
+    uint32_t* result)
+{
+    tsStatus status;
+    return tsGetUInt32Checked(pCurr, pEnd, result, &status);
+}
+
+const char* tsGetFloatChecked(
+    const char* pCurr, const char* pEnd,
+    float* result,
+    tsStatus* status)
+{
+    // Read through the double path, whose mantissa and exponent cover any
+    // float, then narrow.
+    double ret;
+    pCurr = tsGetDoubleChecked(pCurr, pEnd, &ret, status);
+
+    *result = (float) ret;
+    if (isinf(*result) && !isinf(ret) && *status == tsOk)
+        *status = tsErrorOverflow;
     return pCurr;
 }
 
@@ -516,54 +840,109 @@ const char* tsGetFloat(
     const char* pCurr, const char* pEnd,
     float* result)
 {
-    pCurr = tsScanForNonWhiteSpace(pCurr, pEnd);
+    tsStatus status;
+    return tsGetFloatChecked(pCurr, pEnd, result, &status);
+}
 
-    float ret = 0.0f;
+const char* tsGetDoubleChecked(
+    const char* pCurr, const char* pEnd,
+    double* result,
+    tsStatus* status)
+{
+    pCurr = tsScanForNonWhiteSpace(pCurr, pEnd);
 
     bool signFlip = false;
 
-    if (*pCurr == '+')
+    if (pCurr < pEnd && *pCurr == '+')
     {
         ++pCurr;
     }
-    else if (*pCurr == '-')
+    else if (pCurr < pEnd && *pCurr == '-')
     {
         ++pCurr;
         signFlip = true;
     }
 
-    // get integer part
-    int32_t intPart;
-    pCurr = tsGetInt32(pCurr, pEnd, &intPart);
-    ret = (float) intPart;
+    // Accumulate up to 19 significant digits exactly, and count the decimal
+    // exponent they are scaled by. Digits beyond those cannot change the
+    // nearest double by more than an ulp, and only adjust the exponent.
+    uint64_t mantissa = 0;
+    int significant = 0;
+    int exponent = 0;
+    bool haveDigits = false;
 
-    // get fractional part
-    if (*pCurr == '.')
+    while (pCurr < pEnd && tsIsNumeric(*pCurr))
     {
+        haveDigits = true;
+        if (significant < 19)
+        {
+            mantissa = mantissa * 10 + (uint64_t)(*pCurr - '0');
+            significant += mantissa != 0;
+        }
+        else
+            ++exponent;
         ++pCurr;
+    }
 
-        float scaler = 0.1f;
-        while (pCurr < pEnd)
+    // a missing integer part is fine if a fraction follows
+    if (pCurr < pEnd && *pCurr == '.')
+    {
+        ++pCurr;
+        while (pCurr < pEnd && tsIsNumeric(*pCurr))
         {
-            if (!tsIsNumeric(*pCurr))
+            haveDigits = true;
+            if (significant < 19)
             {
-                break;
+                mantissa = mantissa * 10 + (uint64_t)(*pCurr - '0');
+                significant += mantissa != 0;
+                --exponent;
             }
-            ret = ret + (float)(*pCurr - '0') * scaler;
             ++pCurr;
-            scaler *= 0.1f;
         }
     }
 
+    if (!haveDigits)
+    {
+        *status = pCurr < pEnd ? tsErrorExpectedNumber : tsErrorEndOfInput;
+        *result = 0.0;
+        return pCurr;
+    }
+    *status = tsOk;
+
     // get exponent
-    if (*pCurr == 'e' || *pCurr == 'E')
+    if (pCurr < pEnd && (*pCurr == 'e' || *pCurr == 'E'))
     {
         ++pCurr;
 
-        pCurr = tsGetInt32(pCurr, pEnd, &intPart);
-        ret *= powf(10.0f, (float) intPart);
+        int32_t e;
+        pCurr = tsGetInt32Checked(pCurr, pEnd, &e, status);
+        if (*status == tsErrorOverflow)
+            e = e < 0 ? -100000 : 100000;   // far beyond the range of double either way
+        if (*status != tsOk && *status != tsErrorOverflow)
+            e = 0;
+        exponent += e < -100000 ? -100000 : e > 100000 ? 100000 : e;
     }
 
+    // Up to 2^53 and 10^22 both operands are exact, so a single multiply or
+    // divide is correctly rounded. Elsewhere pow is close enough.
+    static const double powersOf10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+
+    double ret;
+    if (mantissa == 0)
+        ret = 0.0;
+    else if (mantissa <= ((uint64_t) 1 << 53) && exponent >= -22 && exponent <= 22)
+        ret = exponent < 0 ? (double) mantissa / powersOf10[-exponent] : (double) mantissa * powersOf10[exponent];
+    else if (exponent < -300)
+        ret = (double) mantissa * pow(10.0, exponent + 300) * 1e-300;   // keep the intermediate normal
+    else
+        ret = (double) mantissa * pow(10.0, exponent);
+
+    if (isinf(ret) && *status == tsOk)
+        *status = tsErrorOverflow;
+
     if (signFlip)
     {
         ret = -ret;
@@ -575,96 +954,1019 @@ const char* tsGetFloat(
 const char* tsGetDouble(
     const char* pCurr, const char* pEnd,
     double* result)
+{
+    tsStatus status;
+    return tsGetDoubleChecked(pCurr, pEnd, result, &status);
+}
+
+//----------------------------------------------------------------------------
+// Timestamps
+
+// Loads eight bytes with the first in the low byte.
+static inline uint64_t tsLoad64(const char* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    return v;
+}
+
+// True if all eight bytes of w are ASCII digits: a digit's high nibble is 3,
+// and stays 3 when 6 is added.
+static inline bool tsIsEightDigits(uint64_t w)
+{
+    const uint64_t ones = 0x0101010101010101ull;
+    return ((w & 0xF0 * ones) | (((w + 0x06 * ones) & 0xF0 * ones) >> 4)) == 0x33 * ones;
+}
+
+// Converts the eight bytes "dd?dd?dd" at p, where ? is sep, to three two
+// digit values with a few word operations instead of a loop over the bytes.
+// Returns false unless all six digits and both separators are as expected.
+static bool tsParseDigitPairs(const char* p, char sep, int* a, int* b, int* c)
+{
+    const uint64_t digitBytes = 0xFFFF00FFFF00FFFFull;
+    const uint64_t ones = 0x0101010101010101ull;
+
+    uint64_t w = tsLoad64(p);
+    if ((w & ~digitBytes) != (uint64_t)(unsigned char) sep * 0x0000010000010000ull)
+        return false;
+
+    // replace the separators with '0' to check the digits in one go
+    uint64_t v = (w & digitBytes) | (0x30 * ones & ~digitBytes);
+    if (!tsIsEightDigits(v))
+        return false;
+
+    // Byte i becomes 10 * digit i + digit i + 1, which cannot carry.
+    uint64_t d = v - 0x30 * ones;
+    uint64_t pairs = d * 10 + (d >> 8);
+    *a = (int) (pairs & 0xFF);
+    *b = (int) ((pairs >> 24) & 0xFF);
+    *c = (int) ((pairs >> 48) & 0xFF);
+    return true;
+}
+
+static bool tsIsLeapYear(int64_t year)
+{
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static int tsDaysInMonth(int64_t year, int month)
+{
+    static const int days[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    return month == 2 && tsIsLeapYear(year) ? 29 : days[month - 1];
+}
+
+// Days from 1970-01-01 to the given proleptic Gregorian date.
+static int64_t tsDaysFromCivil(int64_t year, int month, int day)
+{
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yearOfEra = year - era * 400;
+    int64_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+// Reads .ddd or ,ddd after the seconds. Digits past nanoseconds are
+// consumed and ignored.
+static const char* tsParseFraction(const char* pCurr, const char* pEnd, int64_t* nanoseconds, tsStatus* status)
+{
+    *nanoseconds = 0;
+    if (pCurr == pEnd || (*pCurr != '.' && *pCurr != ','))
+        return pCurr;
+
+    static const int32_t scale[] = { 1000000000, 100000000, 10000000, 1000000, 100000, 10000, 1000, 100, 10, 1 };
+
+    const char* pDigits = ++pCurr;
+    const char* pLast = pEnd - pCurr > 9 ? pCurr + 9 : pEnd;
+    int32_t value = 0;
+    while (pCurr < pLast && tsIsNumeric(*pCurr))
+        value = value * 10 + (*pCurr++ - '0');
+    *nanoseconds = (int64_t) value * scale[pCurr - pDigits];
+    while (pCurr < pEnd && tsIsNumeric(*pCurr))
+        ++pCurr;
+    if (pCurr == pDigits)
+        *status = tsErrorExpectedNumber;
+    return pCurr;
+}
+
+static bool tsTimestampToNanoseconds(
+    int64_t year, int month, int day,
+    int hour, int minute, int second, int64_t nanoseconds,
+    int64_t offsetSeconds,
+    int64_t* result)
+{
+    int64_t seconds = tsDaysFromCivil(year, month, day) * 86400
+                    + hour * 3600 + minute * 60 + second - offsetSeconds;
+
+    // int64 nanoseconds span 1677-09-21 to 2262-04-11
+    const int64_t maxSeconds = INT64_MAX / 1000000000;
+    if (seconds > maxSeconds || seconds < -maxSeconds - 1)
+        return false;
+    if (seconds == maxSeconds && nanoseconds > INT64_MAX % 1000000000)
+        return false;
+    if (seconds == -maxSeconds - 1 && nanoseconds < 1000000000 + INT64_MIN % 1000000000)
+        return false;
+
+    // Borrow a second so the product stays in range at the lower bound
+    *result = seconds < 0 && nanoseconds
+            ? (seconds + 1) * 1000000000 + (nanoseconds - 1000000000)
+            : seconds * 1000000000 + nanoseconds;
+    return true;
+}
+
+const char* tsGetTimestampChecked(
+    const char* pCurr, const char* pEnd,
+    int64_t* result,
+    tsStatus* status)
 {
     pCurr = tsScanForNonWhiteSpace(pCurr, pEnd);
+    *result = 0;
+    *status = tsOk;
 
-    double ret = 0.0;
+    // YYYY-MM-DD, as the two digits of the century and "YY-MM-DD"
+    if (pEnd - pCurr < 10)
+    {
+        *status = pCurr < pEnd && tsIsNumeric(*pCurr) ? tsErrorEndOfInput : tsErrorExpectedNumber;
+        return pCurr;
+    }
 
-    bool signFlip = false;
+    int yy, month, day;
+    if (!tsIsNumeric(pCurr[0]) || !tsIsNumeric(pCurr[1]) || !tsParseDigitPairs(pCurr + 2, '-', &yy, &month, &day))
+    {
+        *status = tsIsNumeric(*pCurr) ? tsErrorUnexpectedInput : tsErrorExpectedNumber;
+        return pCurr;
+    }
 
-    if (*pCurr == '+')
+    int64_t year = (pCurr[0] - '0') * 1000 + (pCurr[1] - '0') * 100 + yy;
+    if (month < 1 || month > 12 || day < 1 || day > tsDaysInMonth(year, month))
     {
-        ++pCurr;
+        *status = tsErrorOverflow;
+        return pCurr;
+    }
+
+    // Thh:mm:ss, with T, t or a space; a date alone is midnight
+    const char* pTime = pCurr + 10;
+    int hour = 0, minute = 0, second = 0;
+    int64_t nanoseconds = 0, offsetSeconds = 0;
+    const char* pNext = pTime;
+    if (pTime < pEnd && (*pTime == 'T' || *pTime == 't' || (*pTime == ' ' && pTime + 1 < pEnd && tsIsNumeric(pTime[1]))))
+    {
+        if (pEnd - pTime < 9)
+        {
+            *status = tsErrorEndOfInput;
+            return pTime;
+        }
+        if (!tsParseDigitPairs(pTime + 1, ':', &hour, &minute, &second))
+        {
+            *status = tsErrorUnexpectedInput;
+            return pTime;
+        }
+        if (hour > 23 || minute > 59 || second > 60)   // 60 is a leap second
+        {
+            *status = tsErrorOverflow;
+            return pTime;
+        }
+
+        pNext = tsParseFraction(pTime + 9, pEnd, &nanoseconds, status);
+        if (*status != tsOk)
+            return pNext;
+
+        // Z, or an offset of +hh:mm, +hhmm or +hh; none means UTC
+        if (pNext < pEnd && (*pNext == 'Z' || *pNext == 'z'))
+            ++pNext;
+        else if (pNext < pEnd && (*pNext == '+' || *pNext == '-'))
+        {
+            const char* p = pNext + 1;
+            int offsetHours = 0, offsetMinutes = 0;
+            if (pEnd - p < 2 || !tsIsNumeric(p[0]) || !tsIsNumeric(p[1]))
+            {
+                *status = tsErrorExpectedNumber;
+                return p;
+            }
+            offsetHours = (p[0] - '0') * 10 + (p[1] - '0');
+            p += 2;
+            if (p < pEnd && *p == ':')
+                ++p;
+            if (pEnd - p >= 2 && tsIsNumeric(p[0]) && tsIsNumeric(p[1]))
+            {
+                offsetMinutes = (p[0] - '0') * 10 + (p[1] - '0');
+                p += 2;
+            }
+            else if (p[-1] == ':')
+            {
+                *status = tsErrorExpectedNumber;
+                return p;
+            }
+            if (offsetHours > 23 || offsetMinutes > 59)
+            {
+                *status = tsErrorOverflow;
+                return pNext;
+            }
+            offsetSeconds = (offsetHours * 3600 + offsetMinutes * 60) * (*pNext == '-' ? -1 : 1);
+            pNext = p;
+        }
+    }
+
+    if (!tsTimestampToNanoseconds(year, month, day, hour, minute, second, nanoseconds, offsetSeconds, result))
+    {
+        *status = tsErrorOverflow;
+        return pCurr;
+    }
+    return pNext;
+}
+
+const char* tsGetTimestamp(
+    const char* pCurr, const char* pEnd,
+    int64_t* result)
+{
+    tsStatus status;
+    return tsGetTimestampChecked(pCurr, pEnd, result, &status);
+}
+
+const char* tsGetSyslogTimestampChecked(
+    const char* pCurr, const char* pEnd,
+    int year,
+    int64_t* result,
+    tsStatus* status)
+{
+    static const char months[] = "janfebmaraprmayjunjulaugsepoctnovdec";
+
+    pCurr = tsScanForNonWhiteSpace(pCurr, pEnd);
+    *result = 0;
+    *status = tsOk;
+
+    // Mmm dd hh:mm:ss, with the day padded by a space or a zero, or unpadded
+    if (pEnd - pCurr < 14)
+    {
+        *status = tsErrorEndOfInput;
+        return pCurr;
+    }
+
+    int month = 0;
+    for (int i = 0; i < 12 && !month; ++i)
+        if ((pCurr[0] | 0x20) == months[3 * i] && (pCurr[1] | 0x20) == months[3 * i + 1] && (pCurr[2] | 0x20) == months[3 * i + 2])
+            month = i + 1;
+    if (!month || pCurr[3] != ' ')
+    {
+        *status = tsErrorUnexpectedInput;
+        return pCurr;
+    }
+
+    const char* p = pCurr + 4;
+    if (*p == ' ')
+        ++p;
+    int day = 0;
+    const char* pDay = p;
+    while (p < pEnd && p - pDay < 2 && tsIsNumeric(*p))
+        day = day * 10 + (*p++ - '0');
+    if (p == pDay || p == pEnd || *p != ' ')
+    {
+        *status = p == pDay ? tsErrorExpectedNumber : tsErrorUnexpectedInput;
+        return p;
     }
-    else if (*pCurr == '-')
+    if (day < 1 || day > tsDaysInMonth(year, month))
     {
+        *status = tsErrorOverflow;
+        return pDay;
+    }
+
+    const char* pTime = p + 1;
+    int hour, minute, second;
+    if (pEnd - pTime < 8)
+    {
+        *status = tsErrorEndOfInput;
+        return pTime;
+    }
+    if (!tsParseDigitPairs(pTime, ':', &hour, &minute, &second))
+    {
+        *status = tsErrorUnexpectedInput;
+        return pTime;
+    }
+    if (hour > 23 || minute > 59 || second > 60)
+    {
+        *status = tsErrorOverflow;
+        return pTime;
+    }
+
+    int64_t nanoseconds;
+    const char* pNext = tsParseFraction(pTime + 8, pEnd, &nanoseconds, status);
+    if (*status != tsOk)
+        return pNext;
+
+    if (!tsTimestampToNanoseconds(year, month, day, hour, minute, second, nanoseconds, 0, result))
+    {
+        *status = tsErrorOverflow;
+        return pCurr;
+    }
+    return pNext;
+}
+
+const char* tsGetSyslogTimestamp(
+    const char* pCurr, const char* pEnd,
+    int year,
+    int64_t* result)
+{
+    tsStatus status;
+    return tsGetSyslogTimestampChecked(pCurr, pEnd, year, result, &status);
+}
+
+//----------------------------------------------------------------------------
+// Decimals
+
+static const uint64_t tsPowersOf10[] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+    10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull,
+};
+
+// The number of ASCII digits at the start of w, first byte in the low byte.
+static inline int tsCountLeadingDigits(uint64_t w)
+{
+    const uint64_t ones = 0x0101010101010101ull;
+
+    // Zero bytes where w has digits. A carry out of a byte >= 0xFA only
+    // disturbs the bytes after that non-digit.
+    uint64_t x = ((w & 0xF0 * ones) | (((w + 0x06 * ones) & 0xF0 * ones) >> 4)) ^ 0x33 * ones;
+    uint64_t nonDigit = (((x & 0x7F * ones) + 0x7F * ones) | x) & 0x80 * ones;
+
+    // gather the high bit of each byte into one byte
+    uint32_t bits = (uint32_t) (((nonDigit >> 7) * 0x0102040810204080ull) >> 56);
+    return tsCountTrailingZeros32(bits | 0x100);
+}
+
+// The value of the first count digits of w. They are moved to the top of the
+// word behind '0's, then adjacent digits, pairs and quads are combined in place.
+static inline uint64_t tsDigitsValue(uint64_t w, int count)
+{
+    if (count == 0)
+        return 0;
+    if (count < 8)
+        w = (w << (8 * (8 - count))) | (0x3030303030303030ull >> (8 * count));
+
+    w -= 0x3030303030303030ull;
+    w = (w * 10 + (w >> 8)) & 0x00FF00FF00FF00FFull;
+    w = (w * 100 + (w >> 16)) & 0x0000FFFF0000FFFFull;
+    return (w * 10000 + (w >> 32)) & 0xFFFFFFFFull;
+}
+
+// Up to 19 significant digits, which always fit a uint64, and a summary of
+// the digits beyond them, enough to round correctly.
+typedef struct tsDecimalDigits
+{
+    uint64_t mantissa;
+    int      significant;
+    int64_t  dropped;
+    int      firstDropped;
+    bool     stickyDropped;     // a non-zero digit after the first dropped one
+} tsDecimalDigits;
+
+static const char* tsReadDecimalDigits(const char* pCurr, const char* pEnd, tsDecimalDigits* d)
+{
+    uint64_t mantissa = d->mantissa;
+    int significant = d->significant;
+
+    if (significant == 0)
+        while (pCurr < pEnd && *pCurr == '0')
+            ++pCurr;
+
+    // up to eight digits per load, while they are sure to fit
+    while (significant <= 19 - 8 && pEnd - pCurr >= 8)
+    {
+        uint64_t w = tsLoad64(pCurr);
+        int n = tsCountLeadingDigits(w);
+        mantissa = mantissa * tsPowersOf10[n] + tsDigitsValue(w, n);
+        significant += n;
+        pCurr += n;
+        if (n < 8)
+            break;
+    }
+
+    int64_t dropped = d->dropped;
+    while (pCurr < pEnd && tsIsNumeric(*pCurr))
+    {
+        int digit = *pCurr - '0';
+        if (significant < 19)
+        {
+            mantissa = mantissa * 10 + (uint64_t) digit;
+            significant += mantissa != 0;
+        }
+        else if (dropped++ == 0)
+            d->firstDropped = digit;
+        else
+            d->stickyDropped |= digit != 0;
         ++pCurr;
-        signFlip = true;
     }
 
-    // get integer part
-    int32_t intPart;
-    pCurr = tsGetInt32(pCurr, pEnd, &intPart);
-    ret = (double) intPart;
+    d->mantissa = mantissa;
+    d->significant = significant;
+    d->dropped = dropped;
+    return pCurr;
+}
+
+// Stores d * 10^shift, rounded to an integer. A dropped digit means 19
+// significant ones were kept, so any shift up overflows.
+static tsStatus tsRoundDecimal(const tsDecimalDigits* d, int64_t shift, tsRounding rounding, bool negative, int64_t* result)
+{
+    bool droppedNonZero = d->firstDropped != 0 || d->stickyDropped;
+    uint64_t ret = d->mantissa;
+    int half = -1;                  // the discarded part against one half
+    bool inexact = false;
+    bool overflow = false;
+
+    if (shift > 0)
+    {
+        // zero stays zero however far it is scaled, so any shift is fine
+        if (ret != 0)
+        {
+            if (droppedNonZero || shift > 19 || ret > UINT64_MAX / tsPowersOf10[shift])
+                overflow = true;
+            else
+                ret *= tsPowersOf10[shift];
+        }
+    }
+    else if (shift == 0)
+    {
+        if (d->dropped)
+            half = d->firstDropped > 5 || (d->firstDropped == 5 && d->stickyDropped) ? 1 : d->firstDropped == 5 ? 0 : -1;
+        inexact = droppedNonZero;
+    }
+    else if (shift >= -19)
+    {
+        uint64_t divisor = tsPowersOf10[-shift];
+        uint64_t remainder = ret % divisor;
+        ret /= divisor;
+        half = remainder > divisor / 2 || (remainder == divisor / 2 && droppedNonZero) ? 1 : remainder == divisor / 2 ? 0 : -1;
+        inexact = remainder != 0 || droppedNonZero;
+    }
+    else
+    {
+        // below a tenth of the unit
+        inexact = ret != 0 || droppedNonZero;
+        ret = 0;
+    }
+
+    bool up = false;
+    switch (rounding)
+    {
+        case tsRoundHalfEven:           up = half > 0 || (half == 0 && (ret & 1)); break;
+        case tsRoundHalfAwayFromZero:   up = half >= 0; break;
+        case tsRoundTowardZero:         up = false; break;
+        case tsRoundFloor:              up = inexact && negative; break;
+        case tsRoundCeiling:            up = inexact && !negative; break;
+    }
+    ret += up;
+
+    const uint64_t limit = negative ? (uint64_t) INT64_MAX + 1 : (uint64_t) INT64_MAX;
+    if (overflow || ret > limit)
+    {
+        *result = negative ? INT64_MIN : INT64_MAX;
+        return tsErrorOverflow;
+    }
+
+    *result = negative ? (int64_t) ((uint64_t) 0 - ret) : (int64_t) ret;
+    return tsOk;
+}
+
+const char* tsGetDecimalChecked(
+    const char* pCurr, const char* pEnd,
+    int scale, tsRounding rounding,
+    int64_t* result,
+    tsStatus* status)
+{
+    pCurr = tsScanForNonWhiteSpace(pCurr, pEnd);
 
-    // get fractional part
-    if (*pCurr == '.')
+    bool signFlip = false;
+    if (pCurr < pEnd && *pCurr == '+')
+        ++pCurr;
+    else if (pCurr < pEnd && *pCurr == '-')
     {
         ++pCurr;
+        signFlip = true;
+    }
+
+    tsDecimalDigits d = { 0, 0, 0, 0, false };
 
-        double scaler = 0.1;
-        while (pCurr < pEnd)
+    // Fast path: fewer than eight digits on either side of the point, and no
+    // exponent. Both sides come out of one 16 byte window.
+    if (pEnd - pCurr >= 16)
+    {
+        uint64_t w = tsLoad64(pCurr);
+        uint64_t next = tsLoad64(pCurr + 8);
+        int n = tsCountLeadingDigits(w);
+        int c = n < 8 ? (int) ((w >> (8 * n)) & 0xFF) : 0;
+        if (c == '.')
         {
-            if (!tsIsNumeric(*pCurr))
+            uint64_t f = n == 7 ? next : (w >> (8 * (n + 1))) | (next << (8 * (7 - n)));
+            int fraction = tsCountLeadingDigits(f);
+            if (fraction < 8 && n + fraction > 0 && (pCurr[n + 1 + fraction] | 0x20) != 'e')
             {
-                break;
+                d.mantissa = tsDigitsValue(w, n) * tsPowersOf10[fraction] + tsDigitsValue(f, fraction);
+                *status = tsRoundDecimal(&d, (int64_t) scale - fraction, rounding, signFlip, result);
+                return pCurr + n + 1 + fraction;
             }
-            ret = ret + (double)(*pCurr - '0') * scaler;
-            ++pCurr;
-            scaler *= 0.1f;
+        }
+        else if (n > 0 && n < 8 && (c | 0x20) != 'e')
+        {
+            d.mantissa = tsDigitsValue(w, n);
+            *status = tsRoundDecimal(&d, scale, rounding, signFlip, result);
+            return pCurr + n;
         }
     }
 
-    // get exponent
-    if (*pCurr == 'e' || *pCurr == 'E')
+    // The value is mantissa * 10^exponent, plus whatever was dropped.
+    const char* pDigits = pCurr;
+    pCurr = tsReadDecimalDigits(pCurr, pEnd, &d);
+    bool haveDigits = pCurr != pDigits;
+    int64_t exponent = d.dropped;
+
+    if (pCurr < pEnd && *pCurr == '.')
+    {
+        pDigits = ++pCurr;
+        int64_t dropped = d.dropped;
+        pCurr = tsReadDecimalDigits(pCurr, pEnd, &d);
+        haveDigits |= pCurr != pDigits;
+        exponent -= (pCurr - pDigits) - (d.dropped - dropped);
+    }
+
+    *result = 0;
+    if (!haveDigits)
+    {
+        *status = pCurr < pEnd ? tsErrorExpectedNumber : tsErrorEndOfInput;
+        return pCurr;
+    }
+    *status = tsOk;
+
+    if (pCurr < pEnd && (*pCurr == 'e' || *pCurr == 'E'))
     {
         ++pCurr;
 
-        pCurr = tsGetInt32(pCurr, pEnd, &intPart);
-        ret *= pow(10.0, (double) intPart);
+        int32_t e;
+        pCurr = tsGetInt32Checked(pCurr, pEnd, &e, status);
+        if (*status == tsErrorOverflow)
+            e = e < 0 ? -100000 : 100000;   // far beyond int64 either way
+        if (*status != tsOk && *status != tsErrorOverflow)
+            e = 0;
+        exponent += e < -100000 ? -100000 : e > 100000 ? 100000 : e;
     }
 
-    if (signFlip)
+    tsStatus rounded = tsRoundDecimal(&d, exponent + scale, rounding, signFlip, result);
+    if (*status == tsErrorOverflow || rounded == tsErrorOverflow)
     {
-        ret = -ret;
+        *result = signFlip ? INT64_MIN : INT64_MAX;
+        *status = tsErrorOverflow;
     }
-    *result = ret;
+    else if (*status != tsOk)
+        *result = 0;
     return pCurr;
 }
 
-const char* tsGetHex(
+const char* tsGetDecimal(
     const char* pCurr, const char* pEnd,
-    uint32_t* result)
+    int scale, tsRounding rounding,
+    int64_t* result)
+{
+    tsStatus status;
+    return tsGetDecimalChecked(pCurr, pEnd, scale, rounding, result, &status);
+}
+
+const char* tsGetHexChecked(
+    const char* pCurr, const char* pEnd,
+    uint32_t* result,
+    tsStatus* status)
 {
     pCurr = tsScanForNonWhiteSpace(pCurr, pEnd);
 
-    int ret = 0;
+    uint32_t ret = 0;
+    bool overflow = false;
+    const char* pDigits = pCurr;
 
     while (pCurr < pEnd)
     {
+        uint32_t digit;
         if (tsIsNumeric(*pCurr))
         {
-            ret = ret * 16 + *pCurr - '0';
+            digit = (uint32_t) (*pCurr - '0');
         }
         else if (*pCurr >= 'A' && *pCurr <= 'F')
         {
-            ret = ret * 16 + *pCurr - 'A' + 10;
+            digit = (uint32_t) (*pCurr - 'A' + 10);
         }
         else if (*pCurr >= 'a' && *pCurr <= 'f')
         {
-            ret = ret * 16 + *pCurr - 'a' + 10;
+            digit = (uint32_t) (*pCurr - 'a' + 10);
         }
         else
         {
             break;
         }
+
+        // leading zeros are fine; only a set top nibble is lost by the shift
+        if (ret > 0x0FFFFFFF)
+            overflow = true;
+        ret = ret * 16 + digit;
         ++pCurr;
     }
 
+    if (pCurr == pDigits)
+        *status = pCurr < pEnd ? tsErrorExpectedNumber : tsErrorEndOfInput;
+    else
+        *status = overflow ? tsErrorOverflow : tsOk;
+
     *result = ret;
     return pCurr;
 }
 
+const char* tsGetHex(
+    const char* pCurr, const char* pEnd,
+    uint32_t* result)
+{
+    tsStatus status;
+    return tsGetHexChecked(pCurr, pEnd, result, &status);
+}
+
+//----------------------------------------------------------------------------
+// Diagnostics
+//
+// Nothing on the scanning paths tracks lines; a location is recovered from a
+// byte address only once something actually needs to be reported.
+
+const char* tsStatusString(tsStatus status)
+{
+    switch (status)
+    {
+    case tsOk:                       return "ok";
+    case tsErrorEndOfInput:          return "unexpected end of input";
+    case tsErrorExpectedNumber:      return "expected a number";
+    case tsErrorOverflow:            return "value out of range";
+    case tsErrorExpectedQuote:       return "expected a quoted string";
+    case tsErrorUnterminatedString:  return "unterminated string";
+    case tsErrorUnterminatedComment: return "unterminated comment";
+    case tsErrorUnexpectedInput:     return "unexpected input";
+    }
+    return "unknown error";
+}
+
+// Line breaks are read as tsScanForEndOfLine reads them: CRLF and LFCR pairs
+// count once, and so do lone CR and LF. A pair is only complete when both of
+// its bytes precede pStop; pEnd bounds the lookahead that tells. pLineStart
+// receives the position just past the last complete break, or pCurr.
+static size_t tsCountBreaks(
+    const char* pCurr, const char* pStop, const char* pEnd,
+    const char** pLineStart)
+{
+    size_t count = 0;
+    const char* pOpen = 0x0;        // first byte of the last break, while a second may pair with it
+    const char* pLine = pCurr;
+    const char* pPrevLine = pCurr;
+
+#define TS_COUNT_BREAK(p)                                       \
+    if (pOpen == (p) - 1 && *(p) != *pOpen)                     \
+    {                                                           \
+        pOpen = 0x0;                                            \
+        pLine = (p) + 1;                                        \
+    }                                                           \
+    else                                                        \
+    {                                                           \
+        ++count;                                                \
+        pOpen = (p);                                            \
+        pPrevLine = pLine;                                      \
+        pLine = (p) + 1;                                        \
+    }
+
+#ifdef TS_SSE2
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    while (pStop - pCurr >= 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*) pCurr);
+        uint32_t m = (uint32_t) _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf)));
+        for (; m; m &= m - 1)
+        {
+            const char* p = pCurr + tsCountTrailingZeros32(m);
+            TS_COUNT_BREAK(p)
+        }
+        pCurr += 16;
+    }
+#endif
+
+    for (; pCurr < pStop; ++pCurr)
+    {
+        if (*pCurr == '\r' || *pCurr == '\n')
+        {
+            TS_COUNT_BREAK(pCurr)
+        }
+    }
+#undef TS_COUNT_BREAK
+
+    // a pair straddling pStop has not been passed yet
+    if (pOpen && pOpen == pStop - 1 && pStop < pEnd &&
+        (*pStop == '\r' || *pStop == '\n') && *pStop != *pOpen)
+    {
+        --count;
+        pLine = pPrevLine;
+    }
+
+    if (pLineStart)
+        *pLineStart = pLine;
+    return count;
+}
+
+size_t tsCountLineBreaks(const char* pCurr, const char* pEnd)
+{
+    Assert(pCurr && pEnd && pEnd >= pCurr);
+    return tsCountBreaks(pCurr, pEnd, pEnd, 0x0);
+}
+
+size_t tsCountLines(const char* pCurr, const char* pEnd)
+{
+    Assert(pCurr && pEnd && pEnd >= pCurr);
+
+    const char* pLine;
+    size_t count = tsCountBreaks(pCurr, pEnd, pEnd, &pLine);
+    return count + (pLine < pEnd);
+}
+
+tsLocation tsLocate(
+    const char* pStart, const char* pEnd,
+    const char* pWhere)
+{
+    Assert(pStart && pEnd && pStart <= pWhere && pWhere <= pEnd);
+
+    const char* pLine;
+    tsLocation location;
+    location.line = 1 + tsCountBreaks(pStart, pWhere, pEnd, &pLine);
+    location.column = 1 + (size_t)(pWhere - pLine);
+    return location;
+}
+
+//----------------------------------------------------------------------------
+// Padded scanning
+//
+// These require that *pEnd is '\0' and that TS_PADDING bytes from pEnd are
+// readable, as arranged by tsPaddedBuffer. Every load is a full unaligned
+// vector, and the loops stop on the sentinel rather than testing pEnd, so
+// there is no tail loop. A match at or past pEnd is clamped to pEnd, which
+// also covers a '\0' embedded in the text.
+//
+// Tokens and whitespace runs are usually short. Each vector step feeds the
+// next load through a count-trailing-zeros, so the short-span scanners check
+// a few bytes one at a time first, where branch prediction can run ahead.
+
+#define TS_PADDED_PRELUDE 8
+
+#ifdef TS_SSE2
+
+static inline uint32_t tsWhiteSpaceMask(__m128i v)
+{
+    __m128i ws = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+    return (uint32_t) _mm_movemask_epi8(ws);
+}
+
+// letters, digits and underscore; bytes above 0x7f compare as negative
+static inline uint32_t tsAlphaNumericMask(__m128i v)
+{
+    __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+    __m128i under = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+    return (uint32_t) _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), under));
+}
+
+#endif
+
+const char* tsPaddedScanForCharacter(
+    const char* pCurr, const char* pEnd,
+    char delim)
+{
+    Assert(pCurr && pEnd && pEnd >= pCurr && *pEnd == '\0');
+
+#ifdef TS_SSE2
+    const __m128i d = _mm_set1_epi8(delim);
+    const __m128i z = _mm_setzero_si128();
+    for (;;)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*) pCurr);
+        uint32_t m = (uint32_t) _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, d), _mm_cmpeq_epi8(v, z)));
+        while (m)
+        {
+            const char* pHit = pCurr + tsCountTrailingZeros32(m);
+            if (pHit >= pEnd)
+                return pEnd;
+            if (*pHit == delim)
+                return pHit;
+            m &= m - 1;
+        }
+        pCurr += 16;
+    }
+#else
+    for (;; ++pCurr)
+        if (*pCurr == delim || (*pCurr == '\0' && pCurr >= pEnd))
+            return pCurr < pEnd ? pCurr : pEnd;
+#endif
+}
+
+const char* tsPaddedScanForWhiteSpace(
+    const char* pCurr, const char* pEnd)
+{
+    Assert(pCurr && pEnd && pEnd >= pCurr && *pEnd == '\0');
+
+    for (int i = 0; i < TS_PADDED_PRELUDE; ++i, ++pCurr)
+    {
+        if (tsIsWhiteSpace(*pCurr))
+            return pCurr < pEnd ? pCurr : pEnd;
+        if (*pCurr == '\0' && pCurr >= pEnd)
+            return pEnd;
+    }
+
+#ifdef TS_SSE2
+    const __m128i z = _mm_setzero_si128();
+    for (;;)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*) pCurr);
+        uint32_t ws = tsWhiteSpaceMask(v);
+        uint32_t m = ws | (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, z));
+        while (m)
+        {
+            int i = tsCountTrailingZeros32(m);
+            const char* pHit = pCurr + i;
+            if (pHit >= pEnd)
+                return pEnd;
+            if (ws & (1u << i))
+                return pHit;
+            m &= m - 1;
+        }
+        pCurr += 16;
+    }
+#else
+    for (;; ++pCurr)
+        if (tsIsWhiteSpace(*pCurr) || (*pCurr == '\0' && pCurr >= pEnd))
+            return pCurr < pEnd ? pCurr : pEnd;
+#endif
+}
+
+const char* tsPaddedScanForNonWhiteSpace(
+    const char* pCurr, const char* pEnd)
+{
+    Assert(pCurr && pEnd && pEnd >= pCurr && *pEnd == '\0');
+
+    // the sentinel is not whitespace, so it always ends the scan
+    for (int i = 0; i < TS_PADDED_PRELUDE; ++i, ++pCurr)
+        if (!tsIsWhiteSpace(*pCurr))
+            return pCurr < pEnd ? pCurr : pEnd;
+
+#ifdef TS_SSE2
+    for (;;)
+    {
+        uint32_t m = ~tsWhiteSpaceMask(_mm_loadu_si128((const __m128i*) pCurr)) & 0xffff;
+        if (m)
+        {
+            const char* pHit = pCurr + tsCountTrailingZeros32(m);
+            return pHit < pEnd ? pHit : pEnd;
+        }
+        pCurr += 16;
+    }
+#else
+    while (tsIsWhiteSpace(*pCurr))
+        ++pCurr;
+    return pCurr < pEnd ? pCurr : pEnd;
+#endif
+}
+
+const char* tsPaddedScanForEndOfLine(
+    const char* pCurr, const char* pEnd)
+{
+    Assert(pCurr && pEnd && pEnd >= pCurr && *pEnd == '\0');
+
+    const char* pHit;
+#ifdef TS_SSE2
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i z = _mm_setzero_si128();
+    for (;;)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*) pCurr);
+        uint32_t eol = (uint32_t) _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, lf)));
+        uint32_t m = eol | (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(v, z));
+        while (m)
+        {
+            int i = tsCountTrailingZeros32(m);
+            pHit = pCurr + i;
+            if (pHit >= pEnd)
+                return pEnd;
+            if (eol & (1u << i))
+                goto found;
+            m &= m - 1;
+        }
+        pCurr += 16;
+    }
+#else
+    for (pHit = pCurr; ; ++pHit)
+    {
+        if (pHit >= pEnd)
+            return pEnd;
+        if (tsIsEndOfLine(*pHit))
+            break;
+    }
+#endif
+
+#ifdef TS_SSE2
+found:
+#endif
+    // same pairing as tsScanForEndOfLine; the padding makes pHit[1] readable
+    if (pHit + 1 < pEnd && (pHit[1] == '\r' || pHit[1] == '\n') && pHit[1] != pHit[0])
+        return pHit + 2;
+    return pHit + 1;
+}
+
+const char* tsPaddedSkipCommentsAndWhitespace(
+    const char* pCurr, const char* pEnd)
+{
+    for (;;)
+    {
+        pCurr = tsPaddedScanForNonWhiteSpace(pCurr, pEnd);
+
+        // pCurr[1] is either text or padding
+        if (pCurr[0] != '/' || pCurr + 1 >= pEnd)
+            return pCurr;
+
+        if (pCurr[1] == '/')
+            pCurr = tsPaddedScanForEndOfLine(pCurr, pEnd);
+        else if (pCurr[1] == '*')
+        {
+            pCurr += 2;
+            for (;;)
+            {
+                pCurr = tsPaddedScanForCharacter(pCurr, pEnd, '*');
+                if (pCurr + 1 >= pEnd)
+                    return pEnd;
+                if (pCurr[1] == '/')
+                {
+                    pCurr += 2;
+                    break;
+                }
+                ++pCurr;
+            }
+        }
+        else
+            return pCurr;
+    }
+}
+
+const char* tsPaddedGetTokenWSDelimited(
+    const char* pCurr, const char* pEnd,
+    const char** resultStringBegin, size_t* stringLength)
+{
+    pCurr = tsPaddedScanForNonWhiteSpace(pCurr, pEnd);
+    *resultStringBegin = pCurr;
+    pCurr = tsPaddedScanForWhiteSpace(pCurr, pEnd);
+    *stringLength = (size_t)(pCurr - *resultStringBegin);
+    return pCurr;
+}
+
+const char* tsPaddedGetTokenAlphaNumeric(
+    const char* pCurr, const char* pEnd,
+    const char** resultStringBegin, size_t* stringLength)
+{
+    pCurr = tsPaddedScanForNonWhiteSpace(pCurr, pEnd);
+    *resultStringBegin = pCurr;
+
+    // the sentinel is not alphanumeric, so it always ends the token
+    const char* pLimit = pCurr + TS_PADDED_PRELUDE;
+    while (pCurr < pLimit && (*pCurr == '_' || tsIsNumeric(*pCurr) || tsIsAlpha(*pCurr)))
+        ++pCurr;
+
+    if (pCurr == pLimit)
+    {
+#ifdef TS_SSE2
+        for (;;)
+        {
+            uint32_t m = ~tsAlphaNumericMask(_mm_loadu_si128((const __m128i*) pCurr)) & 0xffff;
+            if (m)
+            {
+                pCurr += tsCountTrailingZeros32(m);
+                break;
+            }
+            pCurr += 16;
+        }
+#else
+        while (*pCurr == '_' || tsIsNumeric(*pCurr) || tsIsAlpha(*pCurr))
+            ++pCurr;
+#endif
+    }
+
+    if (pCurr > pEnd)
+        pCurr = pEnd;
+
+    *stringLength = (size_t)(pCurr - *resultStringBegin);
+    return pCurr;
+}
+
 bool tsIsIn(const char* testString, char test)
 {
     for (; *testString != '\0'; ++testString)
@@ -39,6 +39,36 @@ License BSD-2 Clause.
     #endif
 #endif
 
+// Status reported by the Checked variants below. The Checked variants scan
+// exactly like their plain counterparts and return the same pointer; on
+// failure the returned pointer is where the problem was detected, and
+// tsLocate turns it into a line and column when a message is needed.
+typedef enum tsStatus {
+    tsOk = 0,
+    tsErrorEndOfInput,          // input ended where a value was required
+    tsErrorExpectedNumber,      // no digits where a number was required
+    tsErrorOverflow,            // digits were read, but don't fit the result
+    tsErrorExpectedQuote,       // no opening quote before the end of input
+    tsErrorUnterminatedString,  // no closing quote before the end of input
+    tsErrorUnterminatedComment, // /* without */ before the end of input
+    tsErrorUnexpectedInput,     // tsExpect did not match
+} tsStatus;
+
+// How tsGetDecimal treats digits below the requested scale.
+typedef enum tsRounding {
+    tsRoundHalfEven = 0,        // to nearest, ties to even
+    tsRoundHalfAwayFromZero,    // to nearest, ties away from zero
+    tsRoundTowardZero,          // truncate
+    tsRoundFloor,               // toward negative infinity
+    tsRoundCeiling,             // toward positive infinity
+} tsRounding;
+
+// 1-based line and column. Columns count bytes.
+typedef struct tsLocation {
+    size_t line;
+    size_t column;
+} tsLocation;
+
 // Get Token
 EXTERNC const char* tsGetToken                      (const char* pCurr, const char* pEnd, char delim, const char** resultStringBegin, uint32_t* stringLength);
 EXTERNC const char* tsGetTokenWSDelimited           (const char* pCurr, const char* pEnd, const char** resultStringBegin, uint32_t* stringLength);
@@ -48,6 +78,20 @@ EXTERNC const char* tsGetTokenExt                   (const char* pCurr, const ch
 
 EXTERNC const char* tsGetNameSpacedTokenAlphaNumeric(const char* pCurr, const char* pEnd, char namespaceChar, const char** resultStringBegin, uint32_t* stringLength);
 
+// Get Token and Get Value with size_t lengths. These are the implementations;
+// the uint32_t length functions above forward to them and truncate, so prefer
+// these for inputs that may hold tokens of 4GiB or more.
+EXTERNC const char* tszGetToken                     (const char* pCurr, const char* pEnd, char delim, const char** resultStringBegin, size_t* stringLength);
+EXTERNC const char* tszGetTokenWSDelimited          (const char* pCurr, const char* pEnd, const char** resultStringBegin, size_t* stringLength);
+EXTERNC const char* tszGetTokenAlphaNumeric         (const char* pCurr, const char* pEnd, const char** resultStringBegin, size_t* stringLength);
+EXTERNC const char* tszGetTokenAlphaNumericExt      (const char* pCurr, const char* pEnd, const char* ext, const char** resultStringBegin, size_t* stringLength);
+EXTERNC const char* tszGetTokenExt                  (const char* pCurr, const char* pEnd, const char* ext, const char** resultStringBegin, size_t* stringLength);
+EXTERNC const char* tszGetNameSpacedTokenAlphaNumeric(const char* pCurr, const char* pEnd, char namespaceChar, const char** resultStringBegin, size_t* stringLength);
+EXTERNC const char* tszGetString                    (const char* pCurr, const char* pEnd, bool recognizeEscapes, const char** resultStringBegin, size_t* stringLength);
+EXTERNC const char* tszGetStringQuoted              (const char* pCurr, const char* pEnd, char strDelim, bool recognizeEscapes, const char** resultStringBegin, size_t* stringLength);
+EXTERNC const char* tszGetStringChecked             (const char* pCurr, const char* pEnd, bool recognizeEscapes, const char** resultStringBegin, size_t* stringLength, tsStatus* status);
+EXTERNC const char* tszGetStringQuotedChecked       (const char* pCurr, const char* pEnd, char strDelim, bool recognizeEscapes, const char** resultStringBegin, size_t* stringLength, tsStatus* status);
+
 // Get Value
 EXTERNC const char* tsGetString                     (const char* pCurr, const char* pEnd, bool recognizeEscapes, const char** resultStringBegin, uint32_t* stringLength);
 EXTERNC const char* tsGetStringQuoted               (const char* pCurr, const char* pEnd, char strDelim, bool recognizeEscapes, const char** resultStringBegin, uint32_t* stringLength);
@@ -58,9 +102,41 @@ EXTERNC const char* tsGetHex                        (const char* pCurr, const ch
 EXTERNC const char* tsGetFloat                      (const char* pcurr, const char* pEnd, float* result);
 EXTERNC const char* tsGetDouble						(const char* pcurr, const char* pEnd, double* result);
 
+// Get Value, reporting failure
+EXTERNC const char* tsGetStringChecked              (const char* pCurr, const char* pEnd, bool recognizeEscapes, const char** resultStringBegin, uint32_t* stringLength, tsStatus* status);
+EXTERNC const char* tsGetStringQuotedChecked        (const char* pCurr, const char* pEnd, char strDelim, bool recognizeEscapes, const char** resultStringBegin, uint32_t* stringLength, tsStatus* status);
+EXTERNC const char* tsGetInt16Checked               (const char* pCurr, const char* pEnd, int16_t* result, tsStatus* status);
+EXTERNC const char* tsGetInt32Checked               (const char* pCurr, const char* pEnd, int32_t* result, tsStatus* status);
+EXTERNC const char* tsGetUInt32Checked              (const char* pCurr, const char* pEnd, uint32_t* result, tsStatus* status);
+EXTERNC const char* tsGetHexChecked                 (const char* pCurr, const char* pEnd, uint32_t* result, tsStatus* status);
+EXTERNC const char* tsGetFloatChecked               (const char* pCurr, const char* pEnd, float* result, tsStatus* status);
+EXTERNC const char* tsGetDoubleChecked              (const char* pCurr, const char* pEnd, double* result, tsStatus* status);
+
+// Timestamps, as nanoseconds since 1970-01-01T00:00:00Z.
+// tsGetTimestamp reads ISO-8601 / RFC-3339: YYYY-MM-DD, optionally followed by
+// T, t or a space and hh:mm:ss, a fraction after . or , and Z or an offset of
+// +hh:mm, +hhmm or +hh. A time without an offset is taken as UTC.
+// tsGetSyslogTimestamp reads the RFC-3164 form "Mmm dd hh:mm:ss", with an
+// optional fraction; syslog omits the year, so the caller supplies it.
+// Out of range fields and dates outside 1677-2262 fail with tsErrorOverflow.
+EXTERNC const char* tsGetTimestamp                  (const char* pCurr, const char* pEnd, int64_t* result);
+EXTERNC const char* tsGetTimestampChecked           (const char* pCurr, const char* pEnd, int64_t* result, tsStatus* status);
+EXTERNC const char* tsGetSyslogTimestamp            (const char* pCurr, const char* pEnd, int year, int64_t* result);
+EXTERNC const char* tsGetSyslogTimestampChecked     (const char* pCurr, const char* pEnd, int year, int64_t* result, tsStatus* status);
+
+// Fixed point decimals. [-]digits[.digits][e±n] is read exactly and stored as
+// value * 10^scale, so "12.345" with scale 2 gives 1234 or 1235, depending on
+// rounding. No floating point is involved. Results beyond int64 fail with
+// tsErrorOverflow and saturate.
+EXTERNC const char* tsGetDecimal                    (const char* pCurr, const char* pEnd, int scale, tsRounding rounding, int64_t* result);
+EXTERNC const char* tsGetDecimalChecked             (const char* pCurr, const char* pEnd, int scale, tsRounding rounding, int64_t* result, tsStatus* status);
+
 EXTERNC const char* tsScanForCharacter              (const char* pCurr, const char* pEnd, char delim);
-EXTERNC const char* tsScanBackwardsForCharacter     (const char* pCurr, const char* pEnd, char delim);
+EXTERNC const char* tsScanBackwardsForCharacter     (const char* pCurr, const char* pStart, char delim);
 EXTERNC const char* tsScanPastString				(const char* pCurr, const char* pEnd, char *pDelim);
+// Returns the first whitespace character, or pEnd if there is none. Earlier
+// versions returned one past it, and pEnd + 1 when there was none; callers
+// that stepped back a byte from the result must no longer do so.
 EXTERNC const char* tsScanForWhiteSpace             (const char* pCurr, const char* pEnd);
 EXTERNC const char* tsScanBackwardsForWhiteSpace    (const char* pCurr, const char* pStart);
 EXTERNC const char* tsScanForNonWhiteSpace          (const char* pCurr, const char* pEnd);
@@ -69,11 +145,166 @@ EXTERNC const char* tsScanForQuote                  (const char* pCurr, const ch
 EXTERNC const char* tsScanForEndOfLine              (const char* pCurr, const char* pEnd);
 EXTERNC const char* tsScanForLastCharacterOnLine    (const char* pCurr, const char* pEnd);
 EXTERNC const char* tsScanForBeginningOfNextLine    (const char* pCurr, const char* pEnd);
+
+// tsScanBackwardsForCharacter and tsScanBackwardsForWhiteSpace test pCurr
+// itself and then earlier bytes down to pStart, and return the byte found, or
+// pStart - 1 if there is none.
+//
+// The To scanners search the half open [pStart, pCurr) from its end instead,
+// and return the position just past the byte found, or pStart if there is
+// none. tsScanBackwardsForBeginningOfLine stops after the nearest '\r' or
+// '\n'.
+EXTERNC const char* tsScanBackwardsToCharacter      (const char* pCurr, const char* pStart, char delim);
+EXTERNC const char* tsScanBackwardsToWhiteSpace     (const char* pCurr, const char* pStart);
+EXTERNC const char* tsScanBackwardsForBeginningOfLine(const char* pCurr, const char* pStart);
 EXTERNC const char* tsScanPastCPPComments           (const char* pCurr, const char* pEnd);
 
+EXTERNC const char* tsScanPastCPPCommentsChecked    (const char* pCurr, const char* pEnd, tsStatus* status);
+
 EXTERNC const char* tsSkipCommentsAndWhitespace     (const char* pCurr, const char*const pEnd);
+EXTERNC const char* tsSkipCommentsAndWhitespaceChecked(const char* pCurr, const char*const pEnd, tsStatus* status);
 
 EXTERNC const char* tsExpect                        (const char* pCurr, const char*const pEnd, const char* pExpect);
+EXTERNC const char* tsExpectChecked                 (const char* pCurr, const char*const pEnd, const char* pExpect, tsStatus* status);
+
+// Diagnostics. These are meant for the error path; they rescan the input
+// from pStart, so nothing needs to be tracked while parsing. Line breaks are
+// those tsScanForEndOfLine reads, so CRLF and LFCR count once. tsCountLines
+// counts the lines a ScanForEndOfLine loop visits: "abc" and "abc\n" are one.
+EXTERNC const char* tsStatusString                  (tsStatus status);
+EXTERNC size_t      tsCountLineBreaks               (const char* pCurr, const char* pEnd);
+EXTERNC size_t      tsCountLines                    (const char* pCurr, const char* pEnd);
+EXTERNC tsLocation  tsLocate                        (const char* pStart, const char* pEnd, const char* pWhere);
+
+// Padded buffers. The text is followed by TS_PADDING zero bytes, the first of
+// which serves as a '\0' sentinel, so scanners may load whole vectors past the
+// end and stop on the sentinel instead of checking bounds on every byte.
+// A mapped buffer is read only; tsPaddedBufferMapFile falls back to reading
+// the file when its last page has no room for the padding.
+#define TS_PADDING 64
+
+typedef struct tsPaddedBuffer {
+    char*  data;
+    size_t length;          // bytes of text, excluding the padding
+    size_t mappedLength;    // non zero if data is a file mapping
+} tsPaddedBuffer;
+
+EXTERNC bool        tsPaddedBufferAlloc             (tsPaddedBuffer* buffer, size_t length);
+EXTERNC bool        tsPaddedBufferCopy              (tsPaddedBuffer* buffer, const char* pCurr, const char* pEnd);
+EXTERNC bool        tsPaddedBufferReadFile          (tsPaddedBuffer* buffer, const char* path);
+EXTERNC bool        tsPaddedBufferMapFile           (tsPaddedBuffer* buffer, const char* path);
+EXTERNC void        tsPaddedBufferFree              (tsPaddedBuffer* buffer);
+
+// Byte sources for chunked readers. A source fills up to capacity bytes and
+// returns the number written, returning 0 only at the end of input.
+typedef size_t (*tsReadFn)(void* user, char* dst, size_t capacity);
+
+// tsReadFn over a FILE*, passed as user
+EXTERNC size_t      tsReadFile                      (void* file, char* dst, size_t capacity);
+
+// A tsReadFn that decompresses another tsReadFn, so compressed input can feed
+// a ChunkReader without being inflated to disk or memory first. The format is
+// detected from the first bytes: gzip (including concatenated members and
+// trailing zero padding) when built with zlib, zstd when built with libzstd,
+// and anything else passes through unchanged. Memory stays bounded by a 64KiB
+// input buffer and the codec's window.
+//
+// Reading stops, returning 0, at the end of input or on error. Status is then
+// tsErrorUnexpectedInput for corrupt data or a format this build cannot
+// decode, tsErrorEndOfInput for a truncated stream, and tsOk otherwise.
+typedef enum tsCompression {
+    tsCompressionNone = 0,
+    tsCompressionGzip,
+    tsCompressionZstd,
+} tsCompression;
+
+typedef struct tsDecompressor tsDecompressor;
+
+EXTERNC tsDecompressor* tsDecompressorOpen          (tsReadFn read, void* user);
+EXTERNC void        tsDecompressorClose             (tsDecompressor* decompressor);
+EXTERNC size_t      tsReadDecompressed              (void* decompressor, char* dst, size_t capacity);
+EXTERNC tsCompression tsDecompressorFormat          (const tsDecompressor* decompressor);
+EXTERNC tsStatus    tsDecompressorStatus            (const tsDecompressor* decompressor);
+
+// Padded scanners; pEnd must be the end of a padded buffer's text.
+EXTERNC const char* tsPaddedScanForCharacter        (const char* pCurr, const char* pEnd, char delim);
+EXTERNC const char* tsPaddedScanForWhiteSpace       (const char* pCurr, const char* pEnd);
+EXTERNC const char* tsPaddedScanForNonWhiteSpace    (const char* pCurr, const char* pEnd);
+EXTERNC const char* tsPaddedScanForEndOfLine        (const char* pCurr, const char* pEnd);
+EXTERNC const char* tsPaddedSkipCommentsAndWhitespace(const char* pCurr, const char* pEnd);
+EXTERNC const char* tsPaddedGetTokenWSDelimited     (const char* pCurr, const char* pEnd, const char** resultStringBegin, size_t* stringLength);
+EXTERNC const char* tsPaddedGetTokenAlphaNumeric    (const char* pCurr, const char* pEnd, const char** resultStringBegin, size_t* stringLength);
+
+// Binary blobs embedded in text. dst needs room for (length + 3) / 4 * 3
+// bytes of base64, or length / 2 bytes of hex; written receives the number of
+// bytes stored. Whitespace between groups of four base64 characters or pairs
+// of hex digits is skipped. Base64 padding is optional. Any other character
+// fails with tsErrorUnexpectedInput, and the returned pointer is the first bad
+// character; input that stops partway through a byte fails with
+// tsErrorEndOfInput. On success the returned pointer is pEnd.
+//
+// The Chunk functions decode input that arrives in pieces, carrying partial
+// groups in the state. Call Begin first and End after the last chunk. A
+// chunk of length n stores at most (n + 3) / 4 * 3 or (n + 1) / 2 bytes, and
+// End may store two more bytes of unpadded base64.
+//
+// Clean runs are decoded with SSE2, or with AVX2 when LabTextDecode.c is
+// compiled with -mavx2, as the LABTEXT_AVX2 CMake option does. That build
+// requires a CPU with AVX2.
+typedef struct tsBase64State {
+    uint32_t bits;          // sextets of an incomplete group
+    uint32_t count;         // 0 to 3
+    uint32_t padding;       // '=' still to come
+    bool     finished;      // padding has begun
+} tsBase64State;
+
+typedef struct tsHexBlobState {
+    uint32_t high;          // the first digit of an incomplete byte
+    uint32_t count;         // 0 or 1
+} tsHexBlobState;
+
+EXTERNC const char* tsDecodeBase64                  (const char* pCurr, const char* pEnd, uint8_t* dst, size_t* written);
+EXTERNC const char* tsDecodeBase64Checked           (const char* pCurr, const char* pEnd, uint8_t* dst, size_t* written, tsStatus* status);
+EXTERNC void        tsDecodeBase64Begin             (tsBase64State* state);
+EXTERNC const char* tsDecodeBase64Chunk             (tsBase64State* state, const char* pCurr, const char* pEnd, uint8_t* dst, size_t* written, tsStatus* status);
+EXTERNC bool        tsDecodeBase64End               (tsBase64State* state, uint8_t* dst, size_t* written, tsStatus* status);
+EXTERNC const char* tsDecodeHexBlob                 (const char* pCurr, const char* pEnd, uint8_t* dst, size_t* written);
+EXTERNC const char* tsDecodeHexBlobChecked          (const char* pCurr, const char* pEnd, uint8_t* dst, size_t* written, tsStatus* status);
+EXTERNC void        tsDecodeHexBlobBegin            (tsHexBlobState* state);
+EXTERNC const char* tsDecodeHexBlobChunk            (tsHexBlobState* state, const char* pCurr, const char* pEnd, uint8_t* dst, size_t* written, tsStatus* status);
+EXTERNC bool        tsDecodeHexBlobEnd              (tsHexBlobState* state, tsStatus* status);
+
+// Normalization before tokenizing, fused into one pass selected by flags. The
+// output is never longer than the input, so dst may be pCurr to work in place;
+// the number of bytes written is returned.
+//  - Lower and Upper map ASCII letters only, and exclude each other.
+//  - CollapseWhiteSpace replaces each run of tsIsWhiteSpace characters with
+//    one space, or with one '\n' if the run holds a line break.
+//  - LineBreaks turns each line break tsScanForEndOfLine reads (CRLF, LFCR, CR
+//    or LF) into '\n'.
+//  - StripComments removes comments as tsScanPastCPPComments delimits them. A
+//    block comment leaves a space, a line comment leaves its line break, and
+//    an unterminated one fails with tsErrorUnterminatedComment. Comments are
+//    not looked for inside a string or character literal that closes on the
+//    line it opens; a quote with no partner on its line is ordinary text.
+// Every other step applies inside literals too, so a combination of flags
+// gives the same result as separate passes of LineBreaks, StripComments,
+// CollapseWhiteSpace and the case change, in that order.
+typedef enum tsNormalizeFlags {
+    tsNormalizeLower                = 1 << 0,
+    tsNormalizeUpper                = 1 << 1,
+    tsNormalizeCollapseWhiteSpace   = 1 << 2,
+    tsNormalizeLineBreaks           = 1 << 3,
+    tsNormalizeStripComments        = 1 << 4,
+} tsNormalizeFlags;
+
+EXTERNC size_t      tsNormalize                     (const char* pCurr, const char* pEnd, char* dst, unsigned flags);
+EXTERNC size_t      tsNormalizeChecked              (const char* pCurr, const char* pEnd, char* dst, unsigned flags, tsStatus* status);
+EXTERNC size_t      tsToLowerAscii                  (const char* pCurr, const char* pEnd, char* dst);
+EXTERNC size_t      tsToUpperAscii                  (const char* pCurr, const char* pEnd, char* dst);
+EXTERNC size_t      tsCollapseWhiteSpace            (const char* pCurr, const char* pEnd, char* dst);
+EXTERNC size_t      tsNormalizeNewlines             (const char* pCurr, const char* pEnd, char* dst);
+EXTERNC size_t      tsStripCppComments              (const char* pCurr, const char* pEnd, char* dst);
 
 EXTERNC bool        tsIsWhiteSpace                  (char test);
 EXTERNC bool        tsIsEndOfLine                   (char test);
@@ -116,6 +347,111 @@ struct StrView {
     }
 };
 
+// A compact reference to text within a base buffer, for storing many tokens
+// from one source. StrRef addresses up to 4GiB with tokens up to 4GiB long in
+// 8 bytes. StrRef40 packs a 40 bit offset and a 24 bit length into 8 bytes,
+// for up to 1TiB of source with tokens shorter than 16MiB. Neither checks its
+// range on construction; the bulk functions below check before writing.
+struct StrRef {
+    uint32_t offset;
+    uint32_t length;
+
+    static const uint64_t maxOffset = 0xffffffffull;
+    static const uint64_t maxLength = 0xffffffffull;
+
+    StrRef() : offset(0), length(0) { }
+    StrRef(size_t offset_, size_t length_) : offset(static_cast<uint32_t>(offset_)), length(static_cast<uint32_t>(length_)) { }
+    StrRef(const char* base, StrView s) : StrRef(static_cast<size_t>(s.current - base), s.length) { }
+
+    size_t Offset() const { return offset; }
+    size_t Length() const { return length; }
+    StrView View(const char* base) const { return StrView(base + offset, length); }
+};
+
+struct StrRef40 {
+    uint64_t bits;  // offset in the low 40 bits, length in the high 24
+
+    static const uint64_t maxOffset = (1ull << 40) - 1;
+    static const uint64_t maxLength = (1ull << 24) - 1;
+
+    StrRef40() : bits(0) { }
+    StrRef40(size_t offset_, size_t length_) : bits(static_cast<uint64_t>(offset_) | (static_cast<uint64_t>(length_) << 40)) { }
+    StrRef40(const char* base, StrView s) : StrRef40(static_cast<size_t>(s.current - base), s.length) { }
+
+    size_t Offset() const { return static_cast<size_t>(bits & maxOffset); }
+    size_t Length() const { return static_cast<size_t>(bits >> 40); }
+    StrView View(const char* base) const { return StrView(base + Offset(), Length()); }
+};
+
+// True if s lies within base and can be held by Ref.
+template<class Ref>
+inline bool
+Fits(StrView base, StrView s) {
+    return s.current >= base.current && s.current + s.length <= base.current + base.length &&
+           static_cast<uint64_t>(s.current - base.current) <= Ref::maxOffset &&
+           static_cast<uint64_t>(s.length) <= Ref::maxLength;
+}
+
+// A StrView whose end is the end of a padded buffer. It can only be consumed
+// from the front, so the sentinel and padding always follow it. It converts
+// to StrView for use with everything else.
+struct PaddedStrView {
+    const char *current;
+    size_t      length;
+
+    PaddedStrView() : current(0x0), length(0) { }
+    explicit PaddedStrView(const tsPaddedBuffer& buffer) : current(buffer.data), length(buffer.length) { }
+
+    operator StrView() const { return StrView(current, length); }
+
+private:
+    friend PaddedStrView Remaining(PaddedStrView, const char*);
+    PaddedStrView(const char *str, size_t len) : current(str), length(len) { }
+};
+
+inline PaddedStrView
+Remaining(PaddedStrView s, const char* next) {
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+// Owns a tsPaddedBuffer. Construction from a StrView copies it; if the copy
+// cannot be allocated no text is held and IsValid returns false.
+class PaddedBuffer {
+    tsPaddedBuffer _buffer;
+
+public:
+    PaddedBuffer() { _buffer.data = 0x0; _buffer.length = 0; _buffer.mappedLength = 0; }
+    PaddedBuffer(StrView s) : PaddedBuffer() { Copy(s); }
+    ~PaddedBuffer() { tsPaddedBufferFree(&_buffer); }
+
+    PaddedBuffer(const PaddedBuffer&) = delete;
+    PaddedBuffer& operator=(const PaddedBuffer&) = delete;
+    PaddedBuffer(PaddedBuffer&& rhs) : _buffer(rhs._buffer) { rhs._buffer.data = 0x0; rhs._buffer.mappedLength = 0; }
+    PaddedBuffer& operator=(PaddedBuffer&& rhs) {
+        if (this != &rhs) {
+            tsPaddedBufferFree(&_buffer);
+            _buffer = rhs._buffer;
+            rhs._buffer.data = 0x0;
+            rhs._buffer.mappedLength = 0;
+        }
+        return *this;
+    }
+
+    bool Copy(StrView s) {
+        tsPaddedBufferFree(&_buffer);
+        return tsPaddedBufferCopy(&_buffer, s.current, s.current + s.length);
+    }
+
+    // map selects tsPaddedBufferMapFile over tsPaddedBufferReadFile
+    bool Load(const char* path, bool map = true) {
+        tsPaddedBufferFree(&_buffer);
+        return map ? tsPaddedBufferMapFile(&_buffer, path) : tsPaddedBufferReadFile(&_buffer, path);
+    }
+
+    bool IsValid() const { return _buffer.data != 0x0; }
+    PaddedStrView View() const { return PaddedStrView(_buffer); }
+};
+
 inline bool
 IsEmpty(const StrView& s) {
     return (s.current == nullptr) || (s.length == 0);
@@ -123,65 +459,49 @@ IsEmpty(const StrView& s) {
 
 inline StrView
 GetToken(StrView s, char delim, StrView& result) {
-    uint32_t sz;
-    const char* next = tsGetToken(s.current, s.current + s.length, delim, &result.current, &sz);
-    result.length = sz;
+    const char* next = tszGetToken(s.current, s.current + s.length, delim, &result.current, &result.length);
     return { next, static_cast<size_t>(s.current + s.length - next) };
 }
 
 inline StrView
 GetTokenWSDelimited(StrView s, char delim, StrView& result) {
-    uint32_t sz;
-    const char* next = tsGetTokenWSDelimited(s.current, s.current + s.length, &result.current, &sz);
-    result.length = sz;
+    const char* next = tszGetTokenWSDelimited(s.current, s.current + s.length, &result.current, &result.length);
     return { next, static_cast<size_t>(s.current + s.length - next) };
 }
 
 inline StrView
 GetTokenAlphaNumeric(StrView s, StrView& result) {
-    uint32_t sz;
-    const char* next = tsGetTokenAlphaNumeric(s.current, s.current + s.length, &result.current, &sz);
-    result.length = sz;
+    const char* next = tszGetTokenAlphaNumeric(s.current, s.current + s.length, &result.current, &result.length);
     return { next, static_cast<size_t>(s.current + s.length - next) };
 }
 
 inline StrView
 GetTokenAlphaNumericExt (StrView s, const char* ext, StrView& result) {
-    uint32_t sz;
-    const char* next = tsGetTokenAlphaNumericExt(s.current, s.current + s.length, ext, &result.current, &sz);
-    result.length = sz;
+    const char* next = tszGetTokenAlphaNumericExt(s.current, s.current + s.length, ext, &result.current, &result.length);
     return { next, static_cast<size_t>(s.current + s.length - next) };
 }
 
 inline StrView
 GetTokenExt(StrView s, const char* ext, StrView& result) {
-    uint32_t sz;
-    const char* next = tsGetTokenExt(s.current, s.current + s.length, ext, &result.current, &sz);
-    result.length = sz;
+    const char* next = tszGetTokenExt(s.current, s.current + s.length, ext, &result.current, &result.length);
     return { next, static_cast<size_t>(s.current + s.length - next) };
 }
 
 inline StrView
 GetNameSpacedTokenAlphaNumeric(StrView s, char namespaceChar, StrView& result) {
-    uint32_t sz;
-    const char* next = tsGetNameSpacedTokenAlphaNumeric(s.current, s.current + s.length, namespaceChar, &result.current, &sz);
-    result.length = sz;
+    const char* next = tszGetNameSpacedTokenAlphaNumeric(s.current, s.current + s.length, namespaceChar, &result.current, &result.length);
     return { next, static_cast<size_t>(s.current + s.length - next) };
 }
 
 inline StrView
 GetString(StrView s, bool recognizeEscapes, StrView& result) {
-    uint32_t sz;
-    const char* next = tsGetString(s.current, s.current + s.length, recognizeEscapes, &result.current, &sz);
-    result.length = sz;
+    const char* next = tszGetString(s.current, s.current + s.length, recognizeEscapes, &result.current, &result.length);
     return { next, static_cast<size_t>(s.current + s.length - next) };
 }
 
 inline StrView
 GetString2(StrView s, char namespaceChar, char strDelim, bool recognizeEscapes, StrView& result) {
-    uint32_t sz;
-    const char* next = tsGetStringQuoted(s.current, s.current + s.length, strDelim, recognizeEscapes, &result.current, &sz);
-    result.length = sz;
+    const char* next = tszGetStringQuoted(s.current, s.current + s.length, strDelim, recognizeEscapes, &result.current, &result.length);
     return { next, static_cast<size_t>(s.current + s.length - next) };
 }
 
@@ -215,16 +535,182 @@ GetFloat(StrView s, float& result) {
     return { next, static_cast<size_t>(s.current + s.length - next) };
 }
 
+inline StrView
+GetDouble(StrView s, double& result) {
+    const char* next = tsGetDouble(s.current, s.current + s.length, &result);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+inline StrView
+GetString(StrView s, bool recognizeEscapes, StrView& result, tsStatus& status) {
+    const char* next = tszGetStringChecked(s.current, s.current + s.length, recognizeEscapes, &result.current, &result.length, &status);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+inline StrView
+GetInt16(StrView s, int16_t& result, tsStatus& status) {
+    const char* next = tsGetInt16Checked(s.current, s.current + s.length, &result, &status);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+inline StrView
+GetInt32(StrView s, int32_t& result, tsStatus& status) {
+    const char* next = tsGetInt32Checked(s.current, s.current + s.length, &result, &status);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+inline StrView
+GetUInt32(StrView s, uint32_t& result, tsStatus& status) {
+    const char* next = tsGetUInt32Checked(s.current, s.current + s.length, &result, &status);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+inline StrView
+GetHex(StrView s, uint32_t& result, tsStatus& status) {
+    const char* next = tsGetHexChecked(s.current, s.current + s.length, &result, &status);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+inline StrView
+GetFloat(StrView s, float& result, tsStatus& status) {
+    const char* next = tsGetFloatChecked(s.current, s.current + s.length, &result, &status);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+inline StrView
+GetDouble(StrView s, double& result, tsStatus& status) {
+    const char* next = tsGetDoubleChecked(s.current, s.current + s.length, &result, &status);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+inline StrView
+GetDecimal(StrView s, int scale, int64_t& result, tsRounding rounding = tsRoundHalfEven) {
+    const char* next = tsGetDecimal(s.current, s.current + s.length, scale, rounding, &result);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+inline StrView
+GetDecimal(StrView s, int scale, int64_t& result, tsStatus& status, tsRounding rounding = tsRoundHalfEven) {
+    const char* next = tsGetDecimalChecked(s.current, s.current + s.length, scale, rounding, &result, &status);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+inline StrView
+GetTimestamp(StrView s, int64_t& result) {
+    const char* next = tsGetTimestamp(s.current, s.current + s.length, &result);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+inline StrView
+GetTimestamp(StrView s, int64_t& result, tsStatus& status) {
+    const char* next = tsGetTimestampChecked(s.current, s.current + s.length, &result, &status);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+inline StrView
+GetSyslogTimestamp(StrView s, int year, int64_t& result) {
+    const char* next = tsGetSyslogTimestamp(s.current, s.current + s.length, year, &result);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+inline StrView
+GetSyslogTimestamp(StrView s, int year, int64_t& result, tsStatus& status) {
+    const char* next = tsGetSyslogTimestampChecked(s.current, s.current + s.length, year, &result, &status);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+// Decode a whole blob. The result is empty on success, or starts at the first
+// bad character.
+inline StrView
+DecodeBase64(StrView s, uint8_t* dst, size_t& written, tsStatus& status) {
+    const char* next = tsDecodeBase64Checked(s.current, s.current + s.length, dst, &written, &status);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+inline StrView
+DecodeHexBlob(StrView s, uint8_t* dst, size_t& written, tsStatus& status) {
+    const char* next = tsDecodeHexBlobChecked(s.current, s.current + s.length, dst, &written, &status);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+// Decode one chunk of a blob; see tsDecodeBase64Chunk.
+inline StrView
+DecodeBase64(tsBase64State& state, StrView chunk, uint8_t* dst, size_t& written, tsStatus& status) {
+    const char* next = tsDecodeBase64Chunk(&state, chunk.current, chunk.current + chunk.length, dst, &written, &status);
+    return { next, static_cast<size_t>(chunk.current + chunk.length - next) };
+}
+
+inline StrView
+DecodeHexBlob(tsHexBlobState& state, StrView chunk, uint8_t* dst, size_t& written, tsStatus& status) {
+    const char* next = tsDecodeHexBlobChunk(&state, chunk.current, chunk.current + chunk.length, dst, &written, &status);
+    return { next, static_cast<size_t>(chunk.current + chunk.length - next) };
+}
+
+// Normalize s into dst, which may be s.current when the caller owns the text;
+// see tsNormalize. The result views the normalized text in dst.
+inline StrView
+Normalize(StrView s, char* dst, unsigned flags) {
+    return { dst, tsNormalize(s.current, s.current + s.length, dst, flags) };
+}
+
+inline StrView
+Normalize(StrView s, char* dst, unsigned flags, tsStatus& status) {
+    return { dst, tsNormalizeChecked(s.current, s.current + s.length, dst, flags, &status) };
+}
+
+inline StrView
+ToLowerAscii(StrView s, char* dst) {
+    return { dst, tsToLowerAscii(s.current, s.current + s.length, dst) };
+}
+
+inline StrView
+ToUpperAscii(StrView s, char* dst) {
+    return { dst, tsToUpperAscii(s.current, s.current + s.length, dst) };
+}
+
+inline StrView
+CollapseWhiteSpace(StrView s, char* dst) {
+    return { dst, tsCollapseWhiteSpace(s.current, s.current + s.length, dst) };
+}
+
+inline StrView
+NormalizeNewlines(StrView s, char* dst) {
+    return { dst, tsNormalizeNewlines(s.current, s.current + s.length, dst) };
+}
+
+inline StrView
+StripCppComments(StrView s, char* dst) {
+    return { dst, tsStripCppComments(s.current, s.current + s.length, dst) };
+}
+
+// Converts a column of timestamp fields. A field that fails to parse gets
+// INT64_MIN. Returns the number converted successfully.
+inline size_t
+GetTimestamps(const StrView* column, size_t count, int64_t* results) {
+    size_t converted = 0;
+    for (size_t i = 0; i < count; ++i) {
+        tsStatus status;
+        tsGetTimestampChecked(column[i].current, column[i].current + column[i].length, &results[i], &status);
+        if (status == tsOk)
+            ++converted;
+        else
+            results[i] = INT64_MIN;
+    }
+    return converted;
+}
+
 inline StrView
 ScanForCharacter(StrView s, char delim) {
     const char* next = tsScanForCharacter(s.current, s.current + s.length, delim);
     return { next, static_cast<size_t>(s.current + s.length - next) };
 }
 
+// Backwards scans consume s from its end; what remains ends just past the
+// byte found, or is empty if there is none.
 inline StrView
 ScanBackwardsForCharacter(StrView s, char delim) {
-    const char* next = tsScanBackwardsForCharacter(s.current, s.current + s.length, delim);
-    return { next, static_cast<size_t>(s.current + s.length - next) };
+    const char* next = tsScanBackwardsToCharacter(s.current + s.length, s.current, delim);
+    return { s.current, static_cast<size_t>(next - s.current) };
 }
 
 inline StrView
@@ -235,8 +721,8 @@ ScanForWhiteSpace(StrView s) {
 
 inline StrView
 ScanBackwardsForWhiteSpace(StrView s) {
-    const char* next = tsScanBackwardsForWhiteSpace(s.current, s.current + s.length);
-    return { next, static_cast<size_t>(s.current + s.length - next) };
+    const char* next = tsScanBackwardsToWhiteSpace(s.current + s.length, s.current);
+    return { s.current, static_cast<size_t>(next - s.current) };
 }
 
 inline StrView
@@ -295,12 +781,31 @@ SkipCommentsAndWhitespace(StrView s) {
     return { next, static_cast<size_t>(s.current + s.length - next) };
 }
 
+inline StrView
+SkipCommentsAndWhitespace(StrView s, tsStatus& status) {
+    const char* next = tsSkipCommentsAndWhitespaceChecked(s.current, s.current + s.length, &status);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
 inline StrView
 Expect(StrView s, StrView expect) {
     const char* next = tsExpect(s.current, s.current + s.length, expect.current);
     return { next, static_cast<size_t>(s.current + s.length - next) };
 }
 
+inline StrView
+Expect(StrView s, StrView expect, tsStatus& status) {
+    const char* next = tsExpectChecked(s.current, s.current + s.length, expect.current, &status);
+    return { next, static_cast<size_t>(s.current + s.length - next) };
+}
+
+// Line and column of where within source; where is typically the remaining
+// input returned by a call that reported an error.
+inline tsLocation
+Locate(StrView source, StrView where) {
+    return tsLocate(source.current, source.current + source.length, where.current);
+}
+
 inline StrView
 Strip(StrView s) {
     StrView result = ScanForNonWhiteSpace(s);
@@ -312,6 +817,48 @@ Strip(StrView s) {
     return result;
 }
 
+inline PaddedStrView
+ScanForCharacter(PaddedStrView s, char delim) {
+    return Remaining(s, tsPaddedScanForCharacter(s.current, s.current + s.length, delim));
+}
+
+inline PaddedStrView
+ScanForWhiteSpace(PaddedStrView s) {
+    return Remaining(s, tsPaddedScanForWhiteSpace(s.current, s.current + s.length));
+}
+
+inline PaddedStrView
+ScanForNonWhiteSpace(PaddedStrView s) {
+    return Remaining(s, tsPaddedScanForNonWhiteSpace(s.current, s.current + s.length));
+}
+
+inline PaddedStrView
+ScanForEndOfLine(PaddedStrView s) {
+    return Remaining(s, tsPaddedScanForEndOfLine(s.current, s.current + s.length));
+}
+
+inline PaddedStrView
+ScanForEndOfLine(PaddedStrView s, StrView& skipped) {
+    const char* next = tsPaddedScanForEndOfLine(s.current, s.current + s.length);
+    skipped = StrView(s.current, static_cast<size_t>(next - s.current));
+    return Remaining(s, next);
+}
+
+inline PaddedStrView
+SkipCommentsAndWhitespace(PaddedStrView s) {
+    return Remaining(s, tsPaddedSkipCommentsAndWhitespace(s.current, s.current + s.length));
+}
+
+inline PaddedStrView
+GetTokenWSDelimited(PaddedStrView s, StrView& result) {
+    return Remaining(s, tsPaddedGetTokenWSDelimited(s.current, s.current + s.length, &result.current, &result.length));
+}
+
+inline PaddedStrView
+GetTokenAlphaNumeric(PaddedStrView s, StrView& result) {
+    return Remaining(s, tsPaddedGetTokenAlphaNumeric(s.current, s.current + s.length, &result.current, &result.length));
+}
+
 inline std::vector<StrView>
 Split(StrView s, char splitter) {
     std::vector<StrView> result;
@@ -340,6 +887,84 @@ Split(StrView s, char splitter) {
     return result;
 }
 
+// Split, appending references relative to base rather than StrViews. s must
+// lie within base. Returns false, having appended the fields that fit, if a
+// field's offset or length is too large for Ref.
+template<class Ref>
+inline bool
+Split(StrView base, StrView s, char splitter, std::vector<Ref>& result) {
+    const char* curr = s.current;
+    const char* end = s.current + s.length;
+    while (curr < end) {
+        const char* next = tsScanForCharacter(curr, end, splitter);
+        StrView field(curr, static_cast<size_t>(next - curr));
+
+        // like Split, a trailing field is kept only if it is not empty
+        if (next == end && !field.length)
+            break;
+        if (!Fits<Ref>(base, field))
+            return false;
+
+        result.emplace_back(base.current, field);
+        curr = next + 1;
+    }
+    return true;
+}
+
+// ReverseLineRange yields the lines of a text from the last to the first,
+// without their line breaks. They are the lines a forward loop over
+// ScanForEndOfLine would return, so CRLF, LFCR, CR and LF each end one line,
+// and a final line break does not start an empty line. Only the lines read
+// are touched; the tail of a large mapped file costs nothing for the rest.
+//
+//     ReverseLineRange lines(buffer.View());
+//     StrView line;
+//     for (int n = 0; n < 10 && lines.Next(line); ++n)
+//         Print(line);
+
+class ReverseLineRange {
+public:
+    explicit ReverseLineRange(StrView text)
+    : _begin(text.current), _end(text.current + text.length) { }
+
+    bool Next(StrView& line) {
+        if (_end == _begin)
+            return false;
+
+        // A line break ends at _end. Alternating '\r' and '\n' pair up from
+        // the start of their run, so find it once and step through the run.
+        const char* lineEnd = _end;
+        if (_end[-1] == '\r' || _end[-1] == '\n') {
+            if (!_run) {
+                _run = _end - 1;
+                while (_run > _begin && (_run[-1] == '\r' || _run[-1] == '\n') && _run[-1] != *_run)
+                    --_run;
+            }
+            lineEnd = (_end - _run) % 2 == 0 ? _end - 2 : _end - 1;
+        }
+
+        if (_run && lineEnd > _run) {
+            // the previous line break is in the same run
+            line = StrView(lineEnd, 0);
+            _end = lineEnd;
+            return true;
+        }
+
+        _run = nullptr;
+        _end = tsScanBackwardsForBeginningOfLine(lineEnd, _begin);
+        line = StrView(_end, static_cast<size_t>(lineEnd - _end));
+        return true;
+    }
+
+    // The text before the last line returned.
+    StrView Remaining() const { return StrView(_begin, static_cast<size_t>(_end - _begin)); }
+
+private:
+    const char* _begin;
+    const char* _end;
+    const char* _run = nullptr;     // start of the alternating line breaks ending at _end
+};
+
 }} // lab::Text
 
 #endif // cplusplus
@@ -0,0 +1,468 @@
+#include "LabText.h"
+
+//------------------------------------------------------------------------------
+// IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+// Base64 and hex decoding of byte blobs embedded in text. Runs of valid
+// characters are decoded a vector at a time; whitespace, padding and errors
+// drop to a table driven loop, one character at a time, which also carries
+// partial groups across chunk boundaries.
+#include <assert.h>
+#define Assert assert
+
+#if defined(__AVX2__)
+    #define TS_AVX2 1
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define TS_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+// Table values below 64 are digits; the rest classify the character.
+enum {
+    tsDecodeWhiteSpace = 0x40,
+    tsDecodePadding    = 0x41,
+    tsDecodeInvalid    = 0x80,
+};
+
+static const uint8_t tsBase64Values[256] = {
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x40, 0x40, 0x80, 0x80, 0x40, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x40, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x3e, 0x80, 0x80, 0x80, 0x3f,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x80, 0x80, 0x80, 0x41, 0x80, 0x80,
+    0x80, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+    0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+};
+
+static const uint8_t tsHexValues[256] = {
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x40, 0x40, 0x80, 0x80, 0x40, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x40, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+};
+
+//----------------------------------------------------------------------------
+// Base64
+
+#if TS_AVX2
+
+// Decodes 32 base64 characters to 24 bytes, or returns false without writing
+// if any of them is not in the alphabet. Nibble lookups classify and
+// translate each character, after Muła and Lemire.
+static inline bool tsDecodeBase64Block(const char* pCurr, uint8_t* dst)
+{
+    const __m256i lutLo = _mm256_setr_epi8(
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+        0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lutHi = _mm256_setr_epi8(
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+        0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lutRoll = _mm256_setr_epi8(
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+
+    __m256i v = _mm256_loadu_si256((const __m256i*) pCurr);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi32(v, 4), nibble);
+    __m256i lo = _mm256_and_si256(v, nibble);
+    if (!_mm256_testz_si256(_mm256_shuffle_epi8(lutLo, lo), _mm256_shuffle_epi8(lutHi, hi)))
+        return false;
+
+    // '/' shares its high nibble with '+', and is told apart by the compare
+    __m256i slash = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('/'));
+    v = _mm256_add_epi8(v, _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(slash, hi)));
+
+    // Sextets to 12 bit pairs, to 24 bit groups, then three bytes per group
+    // packed to the bottom of each lane and the lanes joined.
+    v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+    v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+    v = _mm256_shuffle_epi8(v, _mm256_setr_epi8(
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+
+    _mm_storeu_si128((__m128i*) dst, _mm256_castsi256_si128(v));
+    _mm_storel_epi64((__m128i*) (dst + 16), _mm256_extracti128_si256(v, 1));
+    return true;
+}
+
+enum { tsBase64Block = 32 };
+
+#elif TS_SSE2
+
+// Decodes 16 base64 characters to 12 bytes, or returns false without writing
+// if any of them is not in the alphabet. Without byte shuffles, ranges are
+// found with compares and the groups are packed with shifts.
+static inline bool tsDecodeBase64Block(const char* pCurr, uint8_t* dst)
+{
+    __m128i v = _mm_loadu_si128((const __m128i*) pCurr);
+
+    // signed compares leave bytes >= 0x80 out of every range
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+    __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('z' + 1)));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+    __m128i plus  = _mm_cmpeq_epi8(v, _mm_set1_epi8('+'));
+    __m128i slash = _mm_cmpeq_epi8(v, _mm_set1_epi8('/'));
+    __m128i valid = _mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, _mm_or_si128(plus, slash)));
+    if (_mm_movemask_epi8(valid) != 0xFFFF)
+        return false;
+
+    __m128i delta = _mm_or_si128(
+        _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-65)), _mm_and_si128(lower, _mm_set1_epi8(-71))),
+        _mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(4)),
+                     _mm_or_si128(_mm_and_si128(plus, _mm_set1_epi8(19)), _mm_and_si128(slash, _mm_set1_epi8(16)))));
+    v = _mm_add_epi8(v, delta);
+
+    // 12 bit pairs in 16 bit lanes, then 24 bit groups in 32 bit lanes, first
+    // sextet highest
+    v = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(v, 6), _mm_set1_epi16(0x0FC0)), _mm_srli_epi16(v, 8));
+    v = _mm_or_si128(_mm_and_si128(_mm_slli_epi32(v, 12), _mm_set1_epi32(0x00FFF000)), _mm_srli_epi32(v, 16));
+
+    // byte order within each group, then two groups per 64 bit lane
+    v = _mm_or_si128(_mm_or_si128(_mm_srli_epi32(v, 16), _mm_and_si128(v, _mm_set1_epi32(0xFF00))),
+                     _mm_slli_epi32(_mm_and_si128(v, _mm_set1_epi32(0xFF)), 16));
+    v = _mm_or_si128(_mm_and_si128(v, _mm_set_epi32(0, -1, 0, -1)), _mm_srli_epi64(_mm_andnot_si128(_mm_set_epi32(0, -1, 0, -1), v), 8));
+
+    uint8_t groups[16];
+    _mm_storeu_si128((__m128i*) groups, v);
+    memcpy(dst, groups, 6);
+    memcpy(dst + 6, groups + 8, 6);
+    return true;
+}
+
+enum { tsBase64Block = 16 };
+
+#endif
+
+void tsDecodeBase64Begin(tsBase64State* state)
+{
+    Assert(state);
+    state->bits = 0;
+    state->count = 0;
+    state->padding = 0;
+    state->finished = false;
+}
+
+const char* tsDecodeBase64Chunk(
+    tsBase64State* state,
+    const char* pCurr, const char* pEnd,
+    uint8_t* dst, size_t* written,
+    tsStatus* status)
+{
+    Assert(state && pCurr && pEnd && pEnd >= pCurr && dst && written && status);
+
+    uint8_t* out = dst;
+    uint32_t bits = state->bits;
+    uint32_t count = state->count;
+    *status = tsOk;
+
+    while (pCurr < pEnd)
+    {
+        if (count == 0 && !state->finished)
+        {
+#if TS_AVX2 || TS_SSE2
+            while (pEnd - pCurr >= tsBase64Block && tsDecodeBase64Block(pCurr, out))
+            {
+                pCurr += tsBase64Block;
+                out += tsBase64Block / 4 * 3;
+            }
+#endif
+            // whole groups of four through the table
+            while (pEnd - pCurr >= 4)
+            {
+                uint32_t a = tsBase64Values[(unsigned char) pCurr[0]];
+                uint32_t b = tsBase64Values[(unsigned char) pCurr[1]];
+                uint32_t c = tsBase64Values[(unsigned char) pCurr[2]];
+                uint32_t d = tsBase64Values[(unsigned char) pCurr[3]];
+                if ((a | b | c | d) & 0xC0)
+                    break;
+                uint32_t group = a << 18 | b << 12 | c << 6 | d;
+                out[0] = (uint8_t) (group >> 16);
+                out[1] = (uint8_t) (group >> 8);
+                out[2] = (uint8_t) group;
+                out += 3;
+                pCurr += 4;
+            }
+            if (pCurr == pEnd)
+                break;
+        }
+
+        // One character: part of a group split by whitespace or a chunk
+        // boundary, whitespace, padding, or an error.
+        uint8_t value = tsBase64Values[(unsigned char) *pCurr];
+        if (value < 64 && !state->finished)
+        {
+            bits = bits << 6 | value;
+            if (++count == 4)
+            {
+                out[0] = (uint8_t) (bits >> 16);
+                out[1] = (uint8_t) (bits >> 8);
+                out[2] = (uint8_t) bits;
+                out += 3;
+                bits = 0;
+                count = 0;
+            }
+        }
+        else if (value == tsDecodePadding && !state->finished && count >= 2)
+        {
+            // xx== holds one byte and xxx= two
+            out[0] = (uint8_t) (bits >> (count == 2 ? 4 : 10));
+            if (count == 3)
+                out[1] = (uint8_t) (bits >> 2);
+            out += count - 1;
+            state->padding = 3 - count;
+            state->finished = true;
+            bits = 0;
+            count = 0;
+        }
+        else if (value == tsDecodePadding && state->finished && state->padding)
+            --state->padding;
+        else if (value != tsDecodeWhiteSpace)
+        {
+            *status = tsErrorUnexpectedInput;
+            break;
+        }
+        ++pCurr;
+    }
+
+    state->bits = bits;
+    state->count = count;
+    *written = (size_t) (out - dst);
+    return pCurr;
+}
+
+bool tsDecodeBase64End(tsBase64State* state, uint8_t* dst, size_t* written, tsStatus* status)
+{
+    Assert(state && dst && written && status);
+
+    // unpadded input may end with two or three characters of a group
+    *written = 0;
+    *status = state->count == 1 || state->padding ? tsErrorEndOfInput : tsOk;
+    if (*status == tsOk && state->count >= 2)
+    {
+        dst[0] = (uint8_t) (state->bits >> (state->count == 2 ? 4 : 10));
+        if (state->count == 3)
+            dst[1] = (uint8_t) (state->bits >> 2);
+        *written = state->count - 1;
+    }
+    tsDecodeBase64Begin(state);
+    return *status == tsOk;
+}
+
+const char* tsDecodeBase64Checked(
+    const char* pCurr, const char* pEnd,
+    uint8_t* dst, size_t* written,
+    tsStatus* status)
+{
+    tsBase64State state;
+    tsDecodeBase64Begin(&state);
+    pCurr = tsDecodeBase64Chunk(&state, pCurr, pEnd, dst, written, status);
+    if (*status == tsOk)
+    {
+        size_t tail;
+        tsDecodeBase64End(&state, dst + *written, &tail, status);
+        *written += tail;
+    }
+    return pCurr;
+}
+
+const char* tsDecodeBase64(
+    const char* pCurr, const char* pEnd,
+    uint8_t* dst, size_t* written)
+{
+    tsStatus status;
+    return tsDecodeBase64Checked(pCurr, pEnd, dst, written, &status);
+}
+
+//----------------------------------------------------------------------------
+// Hex
+
+#if TS_AVX2 || TS_SSE2
+
+#if TS_AVX2
+    typedef __m256i tsVector;
+    #define tsLoad(p)           _mm256_loadu_si256((const __m256i*) (p))
+    #define tsSet1(c)           _mm256_set1_epi8(c)
+    #define tsSet1_16(c)        _mm256_set1_epi16(c)
+    #define tsAnd               _mm256_and_si256
+    #define tsOr                _mm256_or_si256
+    #define tsAdd               _mm256_add_epi8
+    #define tsSub               _mm256_sub_epi8
+    #define tsGreater           _mm256_cmpgt_epi8
+    #define tsShiftLeft16       _mm256_slli_epi16
+    #define tsShiftRight16      _mm256_srli_epi16
+    #define tsMoveMask          _mm256_movemask_epi8
+    #define tsAllOnes           ((int) 0xFFFFFFFF)
+#else
+    typedef __m128i tsVector;
+    #define tsLoad(p)           _mm_loadu_si128((const __m128i*) (p))
+    #define tsSet1(c)           _mm_set1_epi8(c)
+    #define tsSet1_16(c)        _mm_set1_epi16(c)
+    #define tsAnd               _mm_and_si128
+    #define tsOr                _mm_or_si128
+    #define tsAdd               _mm_add_epi8
+    #define tsSub               _mm_sub_epi8
+    #define tsGreater           _mm_cmpgt_epi8
+    #define tsShiftLeft16       _mm_slli_epi16
+    #define tsShiftRight16      _mm_srli_epi16
+    #define tsMoveMask          _mm_movemask_epi8
+    #define tsAllOnes           0xFFFF
+#endif
+
+// Nibble values in each byte, or false if any byte is not a hex digit.
+static inline bool tsHexNibbles(const char* pCurr, tsVector* nibbles)
+{
+    tsVector v = tsLoad(pCurr);
+    tsVector folded = tsOr(v, tsSet1(0x20));    // 'A' to 'a'; no digit changes
+
+    // signed compares leave bytes >= 0x80 out of both ranges
+    tsVector digit = tsAnd(tsGreater(v, tsSet1('0' - 1)), tsGreater(tsSet1('9' + 1), v));
+    tsVector alpha = tsAnd(tsGreater(folded, tsSet1('a' - 1)), tsGreater(tsSet1('f' + 1), folded));
+    if (tsMoveMask(tsOr(digit, alpha)) != tsAllOnes)
+        return false;
+
+    *nibbles = tsOr(tsAnd(digit, tsSub(v, tsSet1('0'))), tsAnd(alpha, tsSub(folded, tsSet1('a' - 10))));
+    return true;
+}
+
+// Two nibbles per 16 bit lane to one byte in its low half.
+static inline tsVector tsHexPairs(tsVector nibbles)
+{
+    return tsOr(tsAnd(tsShiftLeft16(nibbles, 4), tsSet1_16(0x00F0)), tsShiftRight16(nibbles, 8));
+}
+
+// Decodes two vectors of hex digits, or returns false without writing.
+static inline bool tsDecodeHexBlock(const char* pCurr, uint8_t* dst)
+{
+    tsVector a, b;
+    if (!tsHexNibbles(pCurr, &a) || !tsHexNibbles(pCurr + sizeof(tsVector), &b))
+        return false;
+#if TS_AVX2
+    // packus works within 128 bit lanes
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(tsHexPairs(a), tsHexPairs(b)), 0xD8);
+    _mm256_storeu_si256((__m256i*) dst, packed);
+#else
+    _mm_storeu_si128((__m128i*) dst, _mm_packus_epi16(tsHexPairs(a), tsHexPairs(b)));
+#endif
+    return true;
+}
+
+enum { tsHexBlock = 2 * sizeof(tsVector) };
+
+#endif
+
+void tsDecodeHexBlobBegin(tsHexBlobState* state)
+{
+    Assert(state);
+    state->high = 0;
+    state->count = 0;
+}
+
+const char* tsDecodeHexBlobChunk(
+    tsHexBlobState* state,
+    const char* pCurr, const char* pEnd,
+    uint8_t* dst, size_t* written,
+    tsStatus* status)
+{
+    Assert(state && pCurr && pEnd && pEnd >= pCurr && dst && written && status);
+
+    uint8_t* out = dst;
+    *status = tsOk;
+
+    while (pCurr < pEnd)
+    {
+        if (state->count == 0)
+        {
+#if TS_AVX2 || TS_SSE2
+            while (pEnd - pCurr >= tsHexBlock && tsDecodeHexBlock(pCurr, out))
+            {
+                pCurr += tsHexBlock;
+                out += tsHexBlock / 2;
+            }
+#endif
+            while (pEnd - pCurr >= 2)
+            {
+                uint32_t hi = tsHexValues[(unsigned char) pCurr[0]];
+                uint32_t lo = tsHexValues[(unsigned char) pCurr[1]];
+                if ((hi | lo) & 0xF0)
+                    break;
+                *out++ = (uint8_t) (hi << 4 | lo);
+                pCurr += 2;
+            }
+            if (pCurr == pEnd)
+                break;
+        }
+
+        // whitespace between bytes, a byte split by a chunk boundary, or an error
+        uint8_t value = tsHexValues[(unsigned char) *pCurr];
+        if (value < 16)
+        {
+            if (state->count)
+                *out++ = (uint8_t) (state->high << 4 | value);
+            else
+                state->high = value;
+            state->count ^= 1;
+        }
+        else if (value != tsDecodeWhiteSpace || state->count)
+        {
+            *status = tsErrorUnexpectedInput;
+            break;
+        }
+        ++pCurr;
+    }
+
+    *written = (size_t) (out - dst);
+    return pCurr;
+}
+
+bool tsDecodeHexBlobEnd(tsHexBlobState* state, tsStatus* status)
+{
+    Assert(state && status);
+    *status = state->count ? tsErrorEndOfInput : tsOk;
+    tsDecodeHexBlobBegin(state);
+    return *status == tsOk;
+}
+
+const char* tsDecodeHexBlobChecked(
+    const char* pCurr, const char* pEnd,
+    uint8_t* dst, size_t* written,
+    tsStatus* status)
+{
+    tsHexBlobState state;
+    tsDecodeHexBlobBegin(&state);
+    pCurr = tsDecodeHexBlobChunk(&state, pCurr, pEnd, dst, written, status);
+    if (*status == tsOk)
+        tsDecodeHexBlobEnd(&state, status);
+    return pCurr;
+}
+
+const char* tsDecodeHexBlob(
+    const char* pCurr, const char* pEnd,
+    uint8_t* dst, size_t* written)
+{
+    tsStatus status;
+    return tsDecodeHexBlobChecked(pCurr, pEnd, dst, written, &status);
+}
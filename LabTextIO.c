@@ -0,0 +1,432 @@
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "LabText.h"
+
+//------------------------------------------------------------------------------
+// IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+    #include <sys/types.h>
+    #include <sys/stat.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#ifdef LABTEXT_HAVE_ZLIB
+    #include <zlib.h>
+#endif
+
+#ifdef LABTEXT_HAVE_ZSTD
+    #include <zstd.h>
+#endif
+
+#include <assert.h>
+#define Assert assert
+
+//----------------------------------------------------------------------------
+
+static void tsPaddedBufferReset(tsPaddedBuffer* buffer)
+{
+    buffer->data = 0x0;
+    buffer->length = 0;
+    buffer->mappedLength = 0;
+}
+
+bool tsPaddedBufferAlloc(tsPaddedBuffer* buffer, size_t length)
+{
+    Assert(buffer);
+
+    tsPaddedBufferReset(buffer);
+    char* data = (char*) malloc(length + TS_PADDING);
+    if (!data)
+        return false;
+
+    memset(data + length, 0, TS_PADDING);
+    buffer->data = data;
+    buffer->length = length;
+    return true;
+}
+
+bool tsPaddedBufferCopy(tsPaddedBuffer* buffer, const char* pCurr, const char* pEnd)
+{
+    Assert(pCurr && pEnd && pEnd >= pCurr);
+
+    if (!tsPaddedBufferAlloc(buffer, (size_t)(pEnd - pCurr)))
+        return false;
+
+    memcpy(buffer->data, pCurr, buffer->length);
+    return true;
+}
+
+bool tsPaddedBufferReadFile(tsPaddedBuffer* buffer, const char* path)
+{
+    Assert(buffer && path);
+
+    tsPaddedBufferReset(buffer);
+
+#ifdef _WIN32
+    struct _stat64 info;
+    if (_stat64(path, &info) != 0)
+        return false;
+#else
+    struct stat info;
+    if (stat(path, &info) != 0)
+        return false;
+#endif
+
+    FILE* file = fopen(path, "rb");
+    if (!file)
+        return false;
+
+    size_t length = (size_t) info.st_size;
+    bool ok = tsPaddedBufferAlloc(buffer, length);
+    if (ok)
+        ok = fread(buffer->data, 1, length, file) == length;
+
+    fclose(file);
+
+    if (!ok)
+        tsPaddedBufferFree(buffer);
+
+    return ok;
+}
+
+bool tsPaddedBufferMapFile(tsPaddedBuffer* buffer, const char* path)
+{
+    Assert(buffer && path);
+
+#ifndef _WIN32
+    tsPaddedBufferReset(buffer);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    // The bytes between the end of the file and the end of its last page
+    // read as zero, so they serve as the padding if there are enough of them.
+    size_t length = (size_t) info.st_size;
+    size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    size_t slack = length % page ? page - length % page : 0;
+
+    if (slack >= TS_PADDING)
+    {
+        void* data = mmap(0x0, length + slack, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED)
+            return false;
+
+        buffer->data = (char*) data;
+        buffer->length = length;
+        buffer->mappedLength = length + slack;
+        return true;
+    }
+
+    close(fd);
+#endif
+
+    return tsPaddedBufferReadFile(buffer, path);
+}
+
+void tsPaddedBufferFree(tsPaddedBuffer* buffer)
+{
+    Assert(buffer);
+
+#ifndef _WIN32
+    if (buffer->mappedLength)
+        munmap(buffer->data, buffer->mappedLength);
+    else
+#endif
+        free(buffer->data);
+
+    tsPaddedBufferReset(buffer);
+}
+
+size_t tsReadFile(void* file, char* dst, size_t capacity)
+{
+    Assert(file && dst);
+
+    // fread may return short counts before the end, so keep going until
+    // capacity is met or the stream is exhausted
+    size_t total = 0;
+    while (total < capacity)
+    {
+        size_t n = fread(dst + total, 1, capacity - total, (FILE*) file);
+        if (n == 0)
+            break;
+        total += n;
+    }
+    return total;
+}
+
+//----------------------------------------------------------------------------
+
+#define TS_DECOMPRESS_BUFFER (64 * 1024)
+
+struct tsDecompressor {
+    tsReadFn      read;
+    void*         user;
+    tsCompression format;
+    tsStatus      status;
+    bool          inStream;     // a gzip member or zstd frame has begun and not ended
+    bool          sourceEnd;    // read has returned 0
+    size_t        inOffset;
+    size_t        inLength;
+    char*         in;
+#ifdef LABTEXT_HAVE_ZLIB
+    z_stream      zlib;
+    bool          zlibInit;
+#endif
+#ifdef LABTEXT_HAVE_ZSTD
+    ZSTD_DStream* zstd;
+#endif
+};
+
+#if defined(LABTEXT_HAVE_ZLIB) || defined(LABTEXT_HAVE_ZSTD)
+// Makes compressed input available, returning false at the end of the source.
+static bool tsDecompressorFill(tsDecompressor* d)
+{
+    if (d->inOffset < d->inLength)
+        return true;
+    if (d->sourceEnd)
+        return false;
+
+    d->inOffset = 0;
+    d->inLength = d->read(d->user, d->in, TS_DECOMPRESS_BUFFER);
+    if (d->inLength == 0)
+        d->sourceEnd = true;
+    return d->inLength != 0;
+}
+#endif
+
+tsDecompressor* tsDecompressorOpen(tsReadFn read, void* user)
+{
+    Assert(read);
+
+    tsDecompressor* d = (tsDecompressor*) calloc(1, sizeof(tsDecompressor));
+    if (!d)
+        return 0x0;
+
+    d->in = (char*) calloc(1, TS_DECOMPRESS_BUFFER);
+    if (!d->in)
+    {
+        free(d);
+        return 0x0;
+    }
+    d->read = read;
+    d->user = user;
+    d->status = tsOk;
+
+    // Gather enough bytes for the longest magic number; a source may return
+    // fewer than asked for.
+    while (d->inLength < 4 && !d->sourceEnd)
+    {
+        size_t n = read(user, d->in + d->inLength, TS_DECOMPRESS_BUFFER - d->inLength);
+        d->inLength += n;
+        d->sourceEnd = n == 0;
+    }
+
+    if (d->inLength >= 2 && !memcmp(d->in, "\x1F\x8B", 2))
+        d->format = tsCompressionGzip;
+    else if (d->inLength >= 4 && !memcmp(d->in, "\x28\xB5\x2F\xFD", 4))
+        d->format = tsCompressionZstd;
+
+    if (d->format == tsCompressionGzip)
+    {
+#ifdef LABTEXT_HAVE_ZLIB
+        // 16 + MAX_WBITS selects the gzip wrapper
+        if (inflateInit2(&d->zlib, 16 + MAX_WBITS) != Z_OK)
+        {
+            tsDecompressorClose(d);
+            return 0x0;
+        }
+        d->zlibInit = true;
+#else
+        d->status = tsErrorUnexpectedInput;
+#endif
+    }
+    else if (d->format == tsCompressionZstd)
+    {
+#ifdef LABTEXT_HAVE_ZSTD
+        d->zstd = ZSTD_createDStream();
+        if (!d->zstd || ZSTD_isError(ZSTD_initDStream(d->zstd)))
+        {
+            tsDecompressorClose(d);
+            return 0x0;
+        }
+#else
+        d->status = tsErrorUnexpectedInput;
+#endif
+    }
+
+    return d;
+}
+
+void tsDecompressorClose(tsDecompressor* d)
+{
+    if (!d)
+        return;
+
+#ifdef LABTEXT_HAVE_ZLIB
+    if (d->zlibInit)
+        inflateEnd(&d->zlib);
+#endif
+#ifdef LABTEXT_HAVE_ZSTD
+    if (d->zstd)
+        ZSTD_freeDStream(d->zstd);
+#endif
+    free(d->in);
+    free(d);
+}
+
+tsCompression tsDecompressorFormat(const tsDecompressor* d)
+{
+    Assert(d);
+    return d->format;
+}
+
+tsStatus tsDecompressorStatus(const tsDecompressor* d)
+{
+    Assert(d);
+    return d->status;
+}
+
+// The codecs may hold output back when dst fills, so they are called again
+// while a stream is open, even once the source is exhausted, until they stop
+// making progress.
+#ifdef LABTEXT_HAVE_ZLIB
+static size_t tsInflate(tsDecompressor* d, char* dst, size_t capacity)
+{
+    z_stream* z = &d->zlib;
+    size_t total = 0;
+    while (total < capacity)
+    {
+        bool more = tsDecompressorFill(d);
+        if (!more && !d->inStream)
+            break;
+
+        // a new member may follow the end of the last one, and zero padding,
+        // as left by tape and block devices, may follow the last member
+        if (!d->inStream)
+        {
+            while (more && d->in[d->inOffset] == 0)
+            {
+                ++d->inOffset;
+                more = tsDecompressorFill(d);
+            }
+            if (!more)
+                break;
+            inflateReset(z);
+            d->inStream = true;
+        }
+
+        size_t room = capacity - total;
+        z->next_in = (Bytef*) d->in + d->inOffset;
+        z->avail_in = (uInt) (d->inLength - d->inOffset);
+        z->next_out = (Bytef*) dst + total;
+        z->avail_out = (uInt) (room > 0x40000000 ? 0x40000000 : room);
+
+        uInt avail = z->avail_out;
+        size_t offset = d->inOffset;
+        int result = inflate(z, Z_NO_FLUSH);
+        total += avail - z->avail_out;
+        d->inOffset = d->inLength - z->avail_in;
+
+        if (result == Z_STREAM_END)
+            d->inStream = false;
+        else if (result != Z_OK && result != Z_BUF_ERROR)
+            d->status = tsErrorUnexpectedInput;
+        if (d->status != tsOk || (avail == z->avail_out && offset == d->inOffset && d->inStream))
+            break;
+    }
+    return total;
+}
+#endif
+
+#ifdef LABTEXT_HAVE_ZSTD
+static size_t tsDecompressZstd(tsDecompressor* d, char* dst, size_t capacity)
+{
+    ZSTD_outBuffer out = { dst, capacity, 0 };
+    while (out.pos < capacity)
+    {
+        bool more = tsDecompressorFill(d);
+        if (!more && !d->inStream)
+            break;
+
+        ZSTD_inBuffer in = { d->in, d->inLength, d->inOffset };
+        size_t pos = out.pos;
+        size_t result = ZSTD_decompressStream(d->zstd, &out, &in);
+        bool progress = out.pos != pos || in.pos != d->inOffset;
+        d->inOffset = in.pos;
+        if (ZSTD_isError(result))
+        {
+            d->status = tsErrorUnexpectedInput;
+            break;
+        }
+
+        // 0 means the frame is complete and flushed; frames may follow
+        d->inStream = result != 0;
+        if (!progress)
+            break;
+    }
+    return out.pos;
+}
+#endif
+
+size_t tsReadDecompressed(void* decompressor, char* dst, size_t capacity)
+{
+    tsDecompressor* d = (tsDecompressor*) decompressor;
+    Assert(d && dst);
+
+    if (d->status != tsOk)
+        return 0;
+
+    size_t total = 0;
+    switch (d->format)
+    {
+    case tsCompressionNone:
+        // drain what format detection buffered, then read straight into dst
+        total = d->inLength - d->inOffset < capacity ? d->inLength - d->inOffset : capacity;
+        memcpy(dst, d->in + d->inOffset, total);
+        d->inOffset += total;
+        while (total < capacity && !d->sourceEnd)
+        {
+            size_t n = d->read(d->user, dst + total, capacity - total);
+            total += n;
+            d->sourceEnd = n == 0;
+        }
+        return total;
+
+#ifdef LABTEXT_HAVE_ZLIB
+    case tsCompressionGzip:
+        total = tsInflate(d, dst, capacity);
+        break;
+#endif
+#ifdef LABTEXT_HAVE_ZSTD
+    case tsCompressionZstd:
+        total = tsDecompressZstd(d, dst, capacity);
+        break;
+#endif
+    default:
+        break;
+    }
+
+    if (total == 0 && d->status == tsOk && d->inStream)
+        d->status = tsErrorEndOfInput;
+    return total;
+}
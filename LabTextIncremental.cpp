@@ -0,0 +1,479 @@
+#include "LabTextIncremental.h"
+
+//------------------------------------------------------------------------------
+// IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+
+#include <assert.h>
+#define Assert assert
+
+namespace lab { namespace Text {
+
+namespace {
+
+bool IsIdentifierChar(char c) {
+    return c == '_' || tsIsNumeric(c) || tsIsAlpha(c);
+}
+
+// What the lexer is in the middle of. Only comments and strings record
+// checkpoints; the others last only until the end of the text at hand.
+enum Mode : uint8_t { Between, LineComment, BlockComment, InString, InIdentifier, InNumber };
+
+// A scan that can stop at any byte and resume there, so a token or comment
+// that runs into the end of the text at hand is never rescanned from its start.
+struct Scan {
+    size_t  pos;        // next byte to examine
+    size_t  begin;      // start of the token or comment being scanned
+    uint8_t mode;
+};
+
+enum Step { Token, Checkpoint, NeedMore, Finished };
+
+// Checkpoints in comments and strings fall every markSpacing bytes, counted
+// back from the end of the document so that they line up again after an edit.
+const size_t markSpacing = 4096;
+
+// The first mark after i. There is none at the end of the document, where
+// nothing follows to resume.
+size_t NextMark(size_t i, size_t length) {
+    size_t r = (length - i) % markSpacing;
+    size_t mark = i + (r ? r : markSpacing);
+    return mark < length ? mark : SIZE_MAX;
+}
+
+// How far the text gap is first pushed when relexing runs up against it.
+// Each further push doubles, so a long token costs a linear number of moves.
+const size_t relexChunk = 4096;
+
+// Lexes forward from s through text[0, end). A checkpoint is taken whenever a
+// comment or string reaches the next mark, before looking at end, so where
+// checkpoints fall does not depend on how the text was split. Returns
+//     Token       the token is [s.begin, s.pos)
+//     Checkpoint  s is at a checkpoint inside a comment or string
+//     NeedMore    s reached end, and last is false
+//     Finished    only whitespace and comments remain
+// last says whether end is the end of the document. Never examines more than
+// one byte past the token it returns.
+Step Lex(const char* text, size_t end, bool last, size_t length, Scan& s, uint8_t* kind) {
+    size_t i = s.pos;
+    size_t limit = NextMark(i, length);
+    for (;;) {
+        switch (s.mode) {
+        case Between:
+            while (i < end && tsIsWhiteSpace(text[i]))
+                ++i;
+            s.begin = i;
+            if (i == end) {
+                s.pos = i;
+                return last ? Finished : NeedMore;
+            }
+            if (text[i] == '/') {
+                if (i + 1 == end && !last) {
+                    s.pos = i;
+                    return NeedMore;
+                }
+                if (i + 1 < end && (text[i + 1] == '/' || text[i + 1] == '*')) {
+                    s.mode = text[i + 1] == '/' ? LineComment : BlockComment;
+                    i += 2;
+                    limit = NextMark(i, length);
+                    continue;
+                }
+            }
+            if (text[i] == '_' || tsIsAlpha(text[i]))
+                s.mode = InIdentifier;
+            else if (tsIsNumeric(text[i]))
+                s.mode = InNumber;
+            else if (text[i] == '"') {
+                s.mode = InString;
+                limit = NextMark(i + 1, length);
+            }
+            else {
+                *kind = IncrementalLexer::Punctuation;
+                s.pos = i + 1;
+                return Token;
+            }
+            ++i;
+            continue;
+
+        case LineComment:
+            for (;; ++i) {
+                if (i >= limit) {
+                    s.pos = i;
+                    return Checkpoint;
+                }
+                if (i == end || text[i] == '\n' || text[i] == '\r')
+                    break;
+            }
+            if (i == end) {
+                s.pos = i;
+                return last ? Finished : NeedMore;
+            }
+            s.mode = Between;
+            continue;
+
+        case BlockComment:
+            for (;; ++i) {
+                if (i >= limit) {
+                    s.pos = i;
+                    return Checkpoint;
+                }
+                if (i + 1 >= end || (text[i] == '*' && text[i + 1] == '/'))
+                    break;
+            }
+            if (i + 1 >= end) {
+                s.pos = i;
+                return last ? Finished : NeedMore;
+            }
+            i += 2;
+            s.mode = Between;
+            continue;
+
+        case InString:
+            for (;;) {
+                if (i >= limit) {
+                    s.pos = i;
+                    return Checkpoint;
+                }
+                if (i >= end)
+                    break;
+                if (text[i] == '\\')
+                    i += 2;     // may step past end; resuming there skips the escaped byte
+                else if (text[i] == '"')
+                    break;
+                else
+                    ++i;
+            }
+            if (i >= end && !last) {
+                s.pos = i;
+                return NeedMore;
+            }
+            // an unterminated string runs to the end of the document
+            s.pos = i < end ? i + 1 : end;
+            s.mode = Between;
+            *kind = IncrementalLexer::String;
+            return Token;
+
+        case InIdentifier:
+            while (i < end && IsIdentifierChar(text[i]))
+                ++i;
+            if (i == end && !last) {
+                s.pos = i;
+                return NeedMore;
+            }
+            s.pos = i;
+            s.mode = Between;
+            *kind = IncrementalLexer::Identifier;
+            return Token;
+
+        default:    // InNumber
+            for (; i < end; ++i) {
+                if (IsIdentifierChar(text[i]) || text[i] == '.')
+                    continue;
+                if ((text[i] == '+' || text[i] == '-') && (text[i - 1] == 'e' || text[i - 1] == 'E'))
+                    continue;
+                break;
+            }
+            if (i == end && !last) {
+                s.pos = i;
+                return NeedMore;
+            }
+            s.pos = i;
+            s.mode = Between;
+            *kind = IncrementalLexer::Number;
+            return Token;
+        }
+    }
+}
+
+} // anon
+
+//----------------------------------------------------------------------------
+
+template<class T>
+void IncrementalLexer::GapArray<T>::Insert(const T& value) {
+    if (gapBegin == gapEnd) {
+        size_t size = data.size();
+        size_t grow = size < 16 ? 16 : size;
+        data.resize(size + grow);
+        std::copy_backward(data.begin() + gapEnd, data.begin() + size, data.end());
+        gapEnd += grow;
+    }
+    data[gapBegin++] = value;
+}
+
+// Moves the gap to index, calling fix on each element that crosses it.
+template<class T>
+template<class Fix>
+void IncrementalLexer::GapArray<T>::MoveGap(size_t index, Fix fix) {
+    while (gapBegin > index) {
+        data[--gapEnd] = data[--gapBegin];
+        fix(data[gapEnd]);
+    }
+    while (gapBegin < index) {
+        data[gapBegin] = data[gapEnd++];
+        fix(data[gapBegin++]);
+    }
+}
+
+//----------------------------------------------------------------------------
+
+IncrementalLexer::IncrementalLexer(StrView text)
+: _length(text.length) {
+    Assert(text.length <= StrRef::maxOffset);
+
+    _text.data.assign(text.current, text.current + text.length);
+    _text.gapBegin = _text.gapEnd = text.length;
+
+    const char* base = _text.data.data();
+    Scan scan = { 0, 0, Between };
+    for (;;) {
+        uint8_t kind;
+        Step step = Lex(base, _length, true, _length, scan, &kind);
+        if (step == Finished)
+            break;
+        if (step == Checkpoint) {
+            Mark mark = { static_cast<uint32_t>(scan.pos), scan.mode };
+            _marks.Insert(mark);
+            continue;
+        }
+        _tokens.Insert(StrRef(scan.begin, scan.pos - scan.begin));
+        _kinds.Insert(kind);
+    }
+
+    for (size_t c = 0; c < _length; ++c)
+        if (BreaksAfter(c))
+            _lines.Insert(static_cast<uint32_t>(c + 1));
+}
+
+// Whether a line starts after byte c: \n, or \r not followed by \n.
+bool IncrementalLexer::BreaksAfter(size_t c) const {
+    char ch = TextAt(c);
+    return ch == '\n' || (ch == '\r' && (c + 1 == _length || TextAt(c + 1) != '\n'));
+}
+
+void IncrementalLexer::MoveTextGap(size_t offset) {
+    // text needs no fixing as it crosses, so it moves as one block
+    char* data = _text.data.data();
+    size_t gap = _text.gapEnd - _text.gapBegin;
+    if (offset < _text.gapBegin)
+        memmove(data + offset + gap, data + offset, _text.gapBegin - offset);
+    else if (offset > _text.gapBegin)
+        memmove(data + _text.gapBegin, data + _text.gapEnd, offset - _text.gapBegin);
+    _text.gapBegin = offset;
+    _text.gapEnd = offset + gap;
+}
+
+StrView IncrementalLexer::Text() {
+    MoveTextGap(_length);
+    return StrView(_text.data.data(), _length);
+}
+
+StrView IncrementalLexer::TokenText(size_t i) const {
+    // the text gap always lies between tokens
+    StrRef ref = Token(i);
+    size_t at = ref.offset < _text.gapBegin ? ref.offset : ref.offset + _text.gapEnd - _text.gapBegin;
+    return StrView(_text.data.data() + at, ref.length);
+}
+
+size_t IncrementalLexer::TokenAt(size_t offset) const {
+    size_t lo = 0, hi = _tokens.Size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (TokenOffset(mid) + _tokens.At(mid).length <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+size_t IncrementalLexer::LineStart(size_t line) const {
+    Assert(line >= 1 && line <= LineCount());
+    return line == 1 ? 0 : LineOffset(line - 2);
+}
+
+tsLocation IncrementalLexer::Locate(size_t offset) const {
+    // count the lines starting at or before offset
+    size_t lo = 0, hi = _lines.Size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (LineOffset(mid) <= offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    tsLocation location;
+    location.line = lo + 1;
+    location.column = offset - LineStart(location.line) + 1;
+    return location;
+}
+
+IncrementalLexer::Change IncrementalLexer::Edit(size_t offset, size_t removed, StrView inserted) {
+    Assert(offset + removed <= _length);
+    Assert(_length - removed + inserted.length <= StrRef::maxOffset);
+
+    const size_t oldLength = _length;
+    const size_t oldEditEnd = offset + removed;
+    const size_t newEditEnd = offset + inserted.length;
+
+    // Tokens ending before offset are unaffected, as lexing one examines at
+    // most the byte after it; lexing resumes at the end of the last of them.
+    // TokenAt gives the first token ending after offset, so step back over
+    // a token ending exactly at offset.
+    size_t first = TokenAt(offset);
+    if (first > 0 && TokenOffset(first - 1) + _tokens.At(first - 1).length == offset)
+        --first;
+    size_t restart = first > 0 ? TokenOffset(first - 1) + _tokens.At(first - 1).length : 0;
+    Scan scan = { restart, restart, Between };
+
+    // A checkpoint before offset depends only on the bytes up to it. One
+    // past restart lies in a comment that follows token first - 1, or in the
+    // string that is token first, and lexing resumes there instead.
+    size_t lo = 0, hi = _marks.Size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (MarkOffset(mid) < offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    size_t markFirst = lo;
+    if (markFirst > 0 && MarkOffset(markFirst - 1) > restart) {
+        scan.pos = MarkOffset(markFirst - 1);
+        scan.mode = _marks.At(markFirst - 1).mode;
+        if (scan.mode == InString)
+            scan.begin = TokenOffset(first);
+    }
+
+    // Line starts decided by bytes offset - 1 through the end of the edit
+    // may change; they begin at lineFirst.
+    lo = 0;
+    hi = _lines.Size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (LineOffset(mid) < offset)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    size_t lineFirst = lo;
+
+    // Move the gaps to the edit while offsets still count from the old end.
+    // Converting between absolute and from the end is its own inverse.
+    _tokens.MoveGap(first, [oldLength](StrRef& ref) { ref.offset = static_cast<uint32_t>(oldLength - ref.offset); });
+    _kinds.MoveGap(first, [](uint8_t&) { });
+    _lines.MoveGap(lineFirst, [oldLength](uint32_t& line) { line = static_cast<uint32_t>(oldLength - line); });
+    _marks.MoveGap(markFirst, [oldLength](Mark& mark) { mark.offset = static_cast<uint32_t>(oldLength - mark.offset); });
+
+    while (_lines.gapEnd < _lines.data.size() && oldLength - _lines.data[_lines.gapEnd] <= oldEditEnd + 1)
+        ++_lines.gapEnd;
+
+    MoveTextGap(offset);
+    _text.gapEnd += removed;
+    for (size_t i = 0; i < inserted.length; ++i)
+        _text.Insert(inserted.current[i]);
+    _length = oldLength - removed + inserted.length;
+
+    // Relex until a token starts where an old token past the edit did, or a
+    // checkpoint past the edit matches an old one. The old tokens and marks
+    // after their gaps are dropped as the new stream passes them. Lexing sees
+    // only the text before the text gap, which is pushed forward, by a
+    // growing step, whenever the scan runs up against it; the scan resumes
+    // where it stopped.
+    Change change;
+    change.first = first;
+    change.removed = 0;
+    change.inserted = 0;
+
+    // old coordinates of a new offset at or past the edit
+    auto toOld = [&](size_t at) { return at - inserted.length + removed; };
+    auto dropMarks = [&](size_t target) {
+        while (_marks.gapEnd < _marks.data.size() && oldLength - _marks.data[_marks.gapEnd].offset < target)
+            ++_marks.gapEnd;
+    };
+    // drops old tokens starting before target, remembering the last of them
+    size_t droppedBegin = 0, droppedEnd = 0;
+    auto dropTokens = [&](size_t target) {
+        while (_tokens.gapEnd < _tokens.data.size() && oldLength - _tokens.data[_tokens.gapEnd].offset < target) {
+            const StrRef& ref = _tokens.data[_tokens.gapEnd];
+            droppedBegin = oldLength - ref.offset;
+            droppedEnd = droppedBegin + ref.length;
+            ++_tokens.gapEnd;
+            ++_kinds.gapEnd;
+            ++change.removed;
+        }
+    };
+
+    size_t step = relexChunk;
+    size_t textGap = SIZE_MAX;     // where to leave the text gap, if not before the next token
+    for (;;) {
+        const char* base = _text.data.data();
+        uint8_t kind;
+        Step result = Lex(base, _text.gapBegin, _text.gapBegin == _length, _length, scan, &kind);
+        if (result == NeedMore) {
+            MoveTextGap(std::min(_text.gapBegin + step, _length));
+            step *= 2;
+            continue;
+        }
+
+        if (result == Checkpoint) {
+            if (scan.pos >= newEditEnd) {
+                size_t target = toOld(scan.pos);
+                dropMarks(target);
+                dropTokens(target);
+                // a string must also have begun where the old one holding the
+                // checkpoint did, which is the last token dropped
+                size_t begin = scan.begin < offset ? scan.begin : scan.begin >= newEditEnd ? toOld(scan.begin) : oldLength;
+                if (_marks.gapEnd < _marks.data.size() &&
+                    oldLength - _marks.data[_marks.gapEnd].offset == target &&
+                    _marks.data[_marks.gapEnd].mode == scan.mode &&
+                    (scan.mode != InString || (droppedBegin == begin && droppedEnd > target))) {
+                    if (scan.mode == InString) {
+                        // the string ends where the old one did
+                        _tokens.Insert(StrRef(scan.begin, droppedEnd - removed + inserted.length - scan.begin));
+                        _kinds.Insert(String);
+                        ++change.inserted;
+                    }
+                    else
+                        textGap = scan.pos;
+                    break;
+                }
+            }
+            Mark mark = { static_cast<uint32_t>(scan.pos), scan.mode };
+            _marks.Insert(mark);
+            continue;
+        }
+
+        bool done = result == Finished;
+        if (done || scan.begin >= newEditEnd) {
+            size_t target = done ? oldLength : toOld(scan.begin);
+            dropMarks(target);
+            dropTokens(target);
+            if (done || (_tokens.gapEnd < _tokens.data.size() && oldLength - _tokens.data[_tokens.gapEnd].offset == target))
+                break;
+        }
+
+        _tokens.Insert(StrRef(scan.begin, scan.pos - scan.begin));
+        _kinds.Insert(kind);
+        ++change.inserted;
+    }
+
+    // Leave the text gap between tokens, so that every token is contiguous.
+    // Inside a comment is between tokens, and saves carrying the gap past
+    // the rest of a long comment and back again on the next edit.
+    if (textGap == SIZE_MAX)
+        textGap = _tokens.gapEnd < _tokens.data.size() ? _length - _tokens.data[_tokens.gapEnd].offset : _length;
+    MoveTextGap(textGap);
+
+    // Rescan the window of line starts the edit may have changed.
+    size_t scanEnd = std::min(newEditEnd + 1, _length);
+    for (size_t c = offset > 0 ? offset - 1 : 0; c < scanEnd; ++c)
+        if (BreaksAfter(c))
+            _lines.Insert(static_cast<uint32_t>(c + 1));
+
+    return change;
+}
+
+}} // lab::Text
@@ -0,0 +1,120 @@
+#pragma once
+
+/*
+ Incremental tokenization of an editable document.
+
+ License BSD-2 Clause.
+*/
+
+#include "LabText.h"
+
+#include <vector>
+
+namespace lab { namespace Text {
+
+// IncrementalLexer owns a document and keeps its token stream and line index
+// current across edits, without rescanning the whole document.
+//
+// Tokens are separated by whitespace and C++ comments, as skipped by
+// SkipCommentsAndWhitespace, and are one of
+//
+//     Identifier   letters, digits and _, not starting with a digit
+//     Number       a digit followed by letters, digits, _ and ., with a sign
+//                  allowed after an exponent e or E
+//     String       a double quoted string, honouring backslash escapes; an
+//                  unterminated string runs to the end of the document
+//     Punctuation  any other single character
+//
+// Between tokens the lexer carries no state, so every token boundary is a
+// checkpoint. Comments and strings also record a checkpoint every 4KiB of
+// their length, holding which of the two the lexer is inside. After an edit,
+// lexing restarts at the last checkpoint before the edit, and stops as soon
+// as it reaches a checkpoint past the edit in the same state as the old one
+// there; from there on the old stream is reused. An edit inside a long
+// comment or string therefore rescans a few KiB around it, not the whole of
+// it, though for a string the text gap is still carried past its end so the
+// token stays contiguous. An edit that opens a comment or string keeps lexing
+// until the stream lines up again, which for an unterminated one is the end
+// of the document.
+//
+// The document, the tokens and the line index are each kept in a gap buffer
+// whose gap sits at the most recent edit. Offsets after a gap are stored
+// relative to the end of the document, so an edit never rewrites them, and
+// checkpoints are spaced from the end for the same reason. The cost of an
+// edit is proportional to the text relexed plus the distance from the
+// previous edit, and does not depend on the size of the document.
+//
+// Tokens are StrRefs, so a document is limited to 4GiB.
+
+class IncrementalLexer {
+public:
+    enum Kind : uint8_t { Identifier, Number, String, Punctuation };
+
+    // Which tokens an edit replaced: tokens [first, first + removed) of the
+    // old stream became tokens [first, first + inserted) of the new one.
+    struct Change {
+        size_t first;
+        size_t removed;
+        size_t inserted;
+    };
+
+    explicit IncrementalLexer(StrView text);
+
+    // Replace removed bytes at offset with inserted.
+    Change Edit(size_t offset, size_t removed, StrView inserted);
+
+    size_t  Length() const { return _length; }
+
+    // The whole document. Closes the text gap, which costs time proportional
+    // to the distance from the last edit to the end.
+    StrView Text();
+
+    size_t  TokenCount() const { return _tokens.Size(); }
+    StrRef  Token(size_t i) const { return StrRef(TokenOffset(i), _tokens.At(i).length); }
+    Kind    TokenKind(size_t i) const { return static_cast<Kind>(_kinds.At(i)); }
+    StrView TokenText(size_t i) const;
+
+    // Index of the first token ending after offset, or TokenCount().
+    size_t  TokenAt(size_t offset) const;
+
+    size_t  LineCount() const { return _lines.Size() + 1; }
+    size_t  LineStart(size_t line) const;  // 1 based, like tsLocation
+    tsLocation Locate(size_t offset) const;
+
+private:
+    template<class T>
+    struct GapArray {
+        std::vector<T> data;
+        size_t gapBegin = 0;
+        size_t gapEnd = 0;
+
+        size_t   Size() const { return data.size() - (gapEnd - gapBegin); }
+        bool     BeforeGap(size_t i) const { return i < gapBegin; }
+        const T& At(size_t i) const { return i < gapBegin ? data[i] : data[i + gapEnd - gapBegin]; }
+        T&       At(size_t i) { return i < gapBegin ? data[i] : data[i + gapEnd - gapBegin]; }
+        void     Insert(const T& value);
+        template<class Fix> void MoveGap(size_t index, Fix fix);
+    };
+
+    // A point inside a comment or string where lexing can resume.
+    struct Mark {
+        uint32_t offset;
+        uint8_t  mode;      // comment or string
+    };
+
+    size_t TokenOffset(size_t i) const { return _tokens.BeforeGap(i) ? _tokens.At(i).offset : _length - _tokens.At(i).offset; }
+    size_t MarkOffset(size_t i) const { return _marks.BeforeGap(i) ? _marks.At(i).offset : _length - _marks.At(i).offset; }
+    size_t LineOffset(size_t i) const { return _lines.BeforeGap(i) ? _lines.At(i) : _length - _lines.At(i); }
+    char   TextAt(size_t i) const { return _text.At(i); }
+    bool   BreaksAfter(size_t c) const;
+    void   MoveTextGap(size_t offset);
+
+    size_t                _length = 0;
+    GapArray<char>        _text;
+    GapArray<StrRef>      _tokens;     // offsets after the gap count from the end
+    GapArray<uint8_t>     _kinds;      // gap kept in step with _tokens
+    GapArray<uint32_t>    _lines;      // starts of lines 2 onwards, likewise
+    GapArray<Mark>        _marks;      // checkpoints in comments and strings, likewise
+};
+
+}} // lab::Text
@@ -0,0 +1,197 @@
+#include "LabTextIni.h"
+
+//------------------------------------------------------------------------------
+// IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+namespace lab { namespace Text {
+
+namespace {
+
+// FNV-1a over the section, a separator that cannot occur in a stripped name,
+// and the key.
+uint32_t Hash(StrView section, StrView key) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < section.length; ++i)
+        h = (h ^ static_cast<unsigned char>(section.current[i])) * 16777619u;
+    h = (h ^ 0xFFu) * 16777619u;
+    for (size_t i = 0; i < key.length; ++i)
+        h = (h ^ static_cast<unsigned char>(key.current[i])) * 16777619u;
+    return h;
+}
+
+bool Same(StrView a, StrView b) {
+    return a.length == b.length && (!a.length || !memcmp(a.current, b.current, a.length));
+}
+
+bool SameIgnoringCase(StrView a, const char* b) {
+    size_t i = 0;
+    for (; i < a.length && b[i]; ++i) {
+        char c = a.current[i];
+        if (c >= 'A' && c <= 'Z')
+            c = static_cast<char>(c - 'A' + 'a');
+        if (c != b[i])
+            return false;
+    }
+    return i == a.length && !b[i];
+}
+
+template<class T>
+bool ParseWhole(StrView value, T& result, StrView (*parse)(StrView, T&, tsStatus&)) {
+    if (!value.length)
+        return false;
+    T parsed;
+    tsStatus status;
+    StrView rest = parse(value, parsed, status);
+    if (status != tsOk || rest.length)
+        return false;
+    result = parsed;
+    return true;
+}
+
+} // anon
+
+ConfigView::ConfigView(StrView text)
+: _base(text.current) {
+    // Entries hold 32-bit offsets, so a larger text cannot be indexed.
+    if (text.length > StrRef::maxOffset) {
+        _status = tsErrorOverflow;
+        _errorOffset = static_cast<size_t>(StrRef::maxOffset);
+        return;
+    }
+
+    // Size the index for one entry per line, so it never rehashes.
+    if (text.length) {
+        size_t lines = tsCountLines(text.current, text.current + text.length);
+        size_t slots = 16;
+        while (slots < lines * 2)
+            slots *= 2;
+        _slots.assign(slots, 0);
+        _entries.reserve(lines);
+    }
+
+    StrView section(text.current, 0);
+    StrView rest = text;
+    while (rest.length) {
+        StrView line;
+        rest = ScanForEndOfLine(rest, line);
+        line = Strip(line);
+        if (!line.length)
+            continue;
+
+        char c = *line.current;
+        if (c == '#' || c == ';' || (c == '/' && line.length > 1 && line.current[1] == '/'))
+            continue;
+
+        if (c == '[') {
+            if (line.current[line.length - 1] == ']')
+                section = Strip(StrView(line.current + 1, line.length - 2));
+            else if (_status == tsOk) {
+                _status = tsErrorUnexpectedInput;
+                _errorOffset = static_cast<size_t>(line.current - _base);
+            }
+            continue;
+        }
+
+        const char* equals = static_cast<const char*>(memchr(line.current, '=', line.length));
+        StrView key = equals ? Strip(StrView(line.current, static_cast<size_t>(equals - line.current))) : StrView();
+        if (!key.length) {
+            if (_status == tsOk) {
+                _status = tsErrorUnexpectedInput;
+                _errorOffset = static_cast<size_t>(line.current - _base);
+            }
+            continue;
+        }
+
+        StrView value = Strip(StrView(equals + 1, static_cast<size_t>(line.current + line.length - equals - 1)));
+        if (value.length >= 2 && value.current[0] == '"' && value.current[value.length - 1] == '"')
+            value = StrView(value.current + 1, value.length - 2);
+
+        Entry entry;
+        entry.section = StrRef(_base, section);
+        entry.key = StrRef(_base, key);
+        entry.value = StrRef(_base, value);
+        entry.hash = Hash(section, key);
+        entry.pad = 0;
+        Insert(entry);
+    }
+}
+
+void ConfigView::Insert(const Entry& entry) {
+    if ((_entries.size() + 1) * 2 > _slots.size()) {
+        _slots.assign(_slots.empty() ? 16 : _slots.size() * 2, 0);
+        size_t mask = _slots.size() - 1;
+        for (size_t i = 0; i < _entries.size(); ++i) {
+            size_t slot = _entries[i].hash & mask;
+            while (_slots[slot])
+                slot = (slot + 1) & mask;
+            _slots[slot] = static_cast<uint32_t>(i + 1);
+        }
+    }
+
+    StrView section = entry.section.View(_base);
+    StrView key = entry.key.View(_base);
+    size_t mask = _slots.size() - 1;
+    size_t slot = entry.hash & mask;
+    for (; _slots[slot]; slot = (slot + 1) & mask) {
+        Entry& other = _entries[_slots[slot] - 1];
+        if (other.hash == entry.hash && Same(other.section.View(_base), section) && Same(other.key.View(_base), key)) {
+            other.value = entry.value;
+            return;
+        }
+    }
+    _entries.push_back(entry);
+    _slots[slot] = static_cast<uint32_t>(_entries.size());
+}
+
+const ConfigView::Entry* ConfigView::Find(StrView section, StrView key) const {
+    if (_slots.empty())
+        return nullptr;
+
+    uint32_t hash = Hash(section, key);
+    size_t mask = _slots.size() - 1;
+    for (size_t slot = hash & mask; _slots[slot]; slot = (slot + 1) & mask) {
+        const Entry& entry = _entries[_slots[slot] - 1];
+        if (entry.hash == hash && Same(entry.section.View(_base), section) && Same(entry.key.View(_base), key))
+            return &entry;
+    }
+    return nullptr;
+}
+
+StrView ConfigView::Get(StrView section, StrView key) const {
+    const Entry* entry = Find(section, key);
+    return entry ? entry->value.View(_base) : StrView();
+}
+
+bool ConfigView::GetInt32(StrView section, StrView key, int32_t& result) const {
+    return ParseWhole<int32_t>(Get(section, key), result, Text::GetInt32);
+}
+
+bool ConfigView::GetUInt32(StrView section, StrView key, uint32_t& result) const {
+    return ParseWhole<uint32_t>(Get(section, key), result, Text::GetUInt32);
+}
+
+bool ConfigView::GetHex(StrView section, StrView key, uint32_t& result) const {
+    return ParseWhole<uint32_t>(Get(section, key), result, Text::GetHex);
+}
+
+bool ConfigView::GetFloat(StrView section, StrView key, float& result) const {
+    return ParseWhole<float>(Get(section, key), result, Text::GetFloat);
+}
+
+bool ConfigView::GetDouble(StrView section, StrView key, double& result) const {
+    return ParseWhole<double>(Get(section, key), result, Text::GetDouble);
+}
+
+bool ConfigView::GetBool(StrView section, StrView key, bool& result) const {
+    StrView value = Get(section, key);
+    if (SameIgnoringCase(value, "true") || SameIgnoringCase(value, "yes") || SameIgnoringCase(value, "on") || SameIgnoringCase(value, "1"))
+        result = true;
+    else if (SameIgnoringCase(value, "false") || SameIgnoringCase(value, "no") || SameIgnoringCase(value, "off") || SameIgnoringCase(value, "0"))
+        result = false;
+    else
+        return false;
+    return true;
+}
+
+}} // lab::Text
@@ -0,0 +1,82 @@
+#pragma once
+
+/*
+ Indexed, zero-copy view of an INI style configuration file.
+
+ License BSD-2 Clause.
+*/
+
+#include "LabText.h"
+
+#include <vector>
+
+namespace lab { namespace Text {
+
+// ConfigView scans a configuration once and answers lookups by section and
+// key in constant time. It keeps StrRefs into the text, which must outlive
+// the view, and parses a value only when a typed getter asks for it.
+//
+//     # comment
+//     // comment
+//     ; comment
+//     global = 1
+//     [server]
+//     host = example.com
+//     port = 8080
+//     name = "quoted, with the quotes removed"
+//
+// Whitespace around sections, keys and values is ignored, and comments take
+// whole lines. Keys before the first section belong to the section "".
+// Names are case sensitive. A repeated key keeps its last value. A line that
+// is none of the above is skipped, and the first such line is reported by
+// Status and ErrorOffset. A text longer than StrRef::maxOffset is not indexed;
+// the view is empty and Status is tsErrorOverflow.
+//
+// The index is a table of 32-byte entries plus an open addressed hash table
+// of 32-bit slots, at most half full.
+
+class ConfigView {
+public:
+    explicit ConfigView(StrView text);
+
+    size_t  Count() const { return _entries.size(); }
+
+    bool    Has(StrView section, StrView key) const { return Find(section, key) != nullptr; }
+
+    // The value, or an empty view if the key is absent.
+    StrView Get(StrView section, StrView key) const;
+
+    // Typed getters leave result untouched and return false if the key is
+    // absent, or its value is not entirely a valid number.
+    bool    GetInt32(StrView section, StrView key, int32_t& result) const;
+    bool    GetUInt32(StrView section, StrView key, uint32_t& result) const;
+    bool    GetHex(StrView section, StrView key, uint32_t& result) const;
+    bool    GetFloat(StrView section, StrView key, float& result) const;
+    bool    GetDouble(StrView section, StrView key, double& result) const;
+
+    // true, yes, on and 1, or false, no, off and 0, in any case.
+    bool    GetBool(StrView section, StrView key, bool& result) const;
+
+    tsStatus Status() const { return _status; }
+    size_t   ErrorOffset() const { return _errorOffset; }
+
+private:
+    struct Entry {
+        StrRef   section;
+        StrRef   key;
+        StrRef   value;
+        uint32_t hash;
+        uint32_t pad;
+    };
+
+    const Entry* Find(StrView section, StrView key) const;
+    void         Insert(const Entry& entry);
+
+    const char*           _base;
+    std::vector<Entry>    _entries;
+    std::vector<uint32_t> _slots;   // entry index + 1, or 0 when empty
+    tsStatus              _status = tsOk;
+    size_t                _errorOffset = 0;
+};
+
+}} // lab::Text
@@ -0,0 +1,461 @@
+#include "LabTextJson.h"
+
+//------------------------------------------------------------------------------
+// IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+#include <assert.h>
+#define Assert assert
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define TS_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+#endif
+
+namespace lab { namespace Text {
+
+namespace {
+
+#if defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
+    int PopCount64(uint64_t v) { return static_cast<int>(__popcnt64(v)); }
+    int CountTrailingZeros64(uint64_t v) { unsigned long i; _BitScanForward64(&i, v); return static_cast<int>(i); }
+#elif defined(__GNUC__) || defined(__clang__)
+    int PopCount64(uint64_t v) { return __builtin_popcountll(v); }
+    int CountTrailingZeros64(uint64_t v) { return __builtin_ctzll(v); }
+#else
+    int PopCount64(uint64_t v) {
+        v = v - ((v >> 1) & 0x5555555555555555ull);
+        v = (v & 0x3333333333333333ull) + ((v >> 2) & 0x3333333333333333ull);
+        return static_cast<int>((((v + (v >> 4)) & 0x0F0F0F0F0F0F0F0Full) * 0x0101010101010101ull) >> 56);
+    }
+    int CountTrailingZeros64(uint64_t v) {
+        int i = 0;
+        while (!(v & 1)) { v >>= 1; ++i; }
+        return i;
+    }
+#endif
+
+// One bit per byte of a 64 byte block.
+struct BlockMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t opens;     // { [
+    uint64_t closes;    // } ]
+    uint64_t separator; // : ,
+    uint64_t space;     // JSON whitespace
+    uint64_t control;   // below 0x20
+};
+
+#ifdef TS_SSE2
+template<class Match>
+uint64_t Mask(const __m128i* v, Match match) {
+    uint64_t m = 0;
+    for (int i = 0; i < 4; ++i)
+        m |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(match(v[i])))) << (16 * i);
+    return m;
+}
+
+__m128i Eq(__m128i v, char c) { return _mm_cmpeq_epi8(v, _mm_set1_epi8(c)); }
+
+void Classify(const char* p, BlockMasks& m) {
+    __m128i v[4];
+    for (int i = 0; i < 4; ++i)
+        v[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+
+    m.quote     = Mask(v, [](__m128i x) { return Eq(x, '"'); });
+    m.backslash = Mask(v, [](__m128i x) { return Eq(x, '\\'); });
+    // { and [ differ only in bit 5, as do } and ]
+    m.opens     = Mask(v, [](__m128i x) { return Eq(_mm_or_si128(x, _mm_set1_epi8(0x20)), '{'); });
+    m.closes    = Mask(v, [](__m128i x) { return Eq(_mm_or_si128(x, _mm_set1_epi8(0x20)), '}'); });
+    m.separator = Mask(v, [](__m128i x) { return _mm_or_si128(Eq(x, ':'), Eq(x, ',')); });
+    m.space     = Mask(v, [](__m128i x) {
+        return _mm_or_si128(_mm_or_si128(Eq(x, ' '), Eq(x, '\t')), _mm_or_si128(Eq(x, '\n'), Eq(x, '\r')));
+    });
+    m.control   = Mask(v, [](__m128i x) {
+        __m128i limit = _mm_set1_epi8(0x1F);
+        return _mm_cmpeq_epi8(_mm_max_epu8(x, limit), limit);
+    });
+}
+#else
+void Classify(const char* p, BlockMasks& m) {
+    m = BlockMasks();
+    for (int i = 0; i < 64; ++i) {
+        uint64_t bit = uint64_t(1) << i;
+        unsigned char c = static_cast<unsigned char>(p[i]);
+        switch (c) {
+        case '"':  m.quote |= bit; break;
+        case '\\': m.backslash |= bit; break;
+        case '{': case '[': m.opens |= bit; break;
+        case '}': case ']': m.closes |= bit; break;
+        case ':': case ',': m.separator |= bit; break;
+        case ' ':  m.space |= bit; break;
+        case '\t': case '\n': case '\r': m.space |= bit; m.control |= bit; break;
+        default:   if (c < 0x20) m.control |= bit; break;
+        }
+    }
+}
+#endif
+
+// Bytes escaped by a backslash. carry is set when the block starts with an
+// escaped byte, and is updated for the next block. Backslashes are rare, so
+// they are walked one run at a time.
+uint64_t Escaped(uint64_t backslash, uint64_t& carry) {
+    uint64_t escaped = carry;
+    backslash &= ~carry;
+    carry = 0;
+    while (backslash) {
+        int i = CountTrailingZeros64(backslash);
+        if (i == 63) {
+            carry = 1;
+            break;
+        }
+        escaped |= uint64_t(2) << i;
+        backslash &= ~(uint64_t(3) << i);
+    }
+    return escaped;
+}
+
+// Bit i becomes the xor of bits 0 through i.
+uint64_t PrefixXor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool IsHexDigit(char c) { return IsDigit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F'); }
+
+// Whether the byte at p, which follows a backslash, starts a valid escape. A
+// backslash at the end of the text escapes nothing.
+bool IsValidEscape(const char* p, const char* end) {
+    if (p >= end)
+        return false;
+    switch (*p) {
+    case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+        return true;
+    case 'u':
+        return end - p > 4 && IsHexDigit(p[1]) && IsHexDigit(p[2]) && IsHexDigit(p[3]) && IsHexDigit(p[4]);
+    }
+    return false;
+}
+
+// Ends a number or literal: whitespace, a structural character, or a quote.
+bool IsDelimiter(char c) {
+    switch (c) {
+    case ' ': case '\t': case '\n': case '\r':
+    case '{': case '}': case '[': case ']': case ':': case ',': case '"':
+        return true;
+    }
+    return false;
+}
+
+// Returns the end of the JSON number at p, or p if there is none.
+const char* ScanNumber(const char* p, const char* end) {
+    const char* start = p;
+    if (p < end && *p == '-')
+        ++p;
+    if (p == end || !IsDigit(*p))
+        return start;
+    if (*p++ != '0')
+        while (p < end && IsDigit(*p))
+            ++p;
+    if (p < end && *p == '.') {
+        if (++p == end || !IsDigit(*p))
+            return start;
+        while (p < end && IsDigit(*p))
+            ++p;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        if (++p < end && (*p == '+' || *p == '-'))
+            ++p;
+        if (p == end || !IsDigit(*p))
+            return start;
+        while (p < end && IsDigit(*p))
+            ++p;
+    }
+    return p;
+}
+
+template<class T>
+tsStatus DecodeNumber(StrView text, T& result,
+                      const char* (*parse)(const char*, const char*, T*, tsStatus*)) {
+    tsStatus status;
+    const char* next = parse(text.current, text.current + text.length, &result, &status);
+    if (status == tsOk && next != text.current + text.length)
+        status = tsErrorUnexpectedInput;
+    return status;
+}
+
+} // anon
+
+//----------------------------------------------------------------------------
+
+JsonReader::JsonReader(StrView json)
+: _base(json.current)
+, _length(json.length) {
+    if (_length)
+        IndexBlock();
+}
+
+// Computes the structural bits of the block at _block.
+void JsonReader::IndexBlock() {
+    BlockMasks m;
+    if (_length - _block >= 64)
+        Classify(_base + _block, m);
+    else {
+        char tail[64];
+        memset(tail, ' ', sizeof(tail));
+        memcpy(tail, _base + _block, _length - _block);
+        Classify(tail, m);
+    }
+
+    uint64_t escaped = Escaped(m.backslash, _escapeCarry);
+    uint64_t quotes = m.quote & ~escaped;
+
+    // set from each opening quote up to, but excluding, its closing quote
+    uint64_t inString = PrefixXor(quotes) ^ _stringCarry;
+    _stringCarry = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+
+    uint64_t outside = ~inString;
+    _opens = m.opens & outside;
+    _closes = m.closes & outside;
+
+    uint64_t scalar = ~(m.opens | m.closes | m.separator | m.space | m.quote) & outside;
+    uint64_t scalarStarts = scalar & ~((scalar << 1) | _scalarCarry);
+    _scalarCarry = scalar >> 63;
+
+    // Control characters and bad escapes inside strings are flagged, so that
+    // the reader meets them where it expects a closing quote.
+    uint64_t invalid = m.control & inString;
+    for (uint64_t e = escaped & inString; e; e &= e - 1) {
+        int i = CountTrailingZeros64(e);
+        if (!IsValidEscape(_base + _block + i, _base + _length))
+            invalid |= uint64_t(1) << i;
+    }
+
+    _bits = _opens | _closes | (m.separator & outside) | quotes | scalarStarts | invalid;
+}
+
+// Offset of the next structural position, or _length if there is none.
+size_t JsonReader::NextIndex() {
+    while (!_bits) {
+        if (_length - _block <= 64)
+            return _length;
+        _block += 64;
+        IndexBlock();
+    }
+    size_t offset = _block + static_cast<size_t>(CountTrailingZeros64(_bits));
+    _bits &= _bits - 1;
+    return offset;
+}
+
+JsonReader::Event JsonReader::Fail(tsStatus status, size_t offset) {
+    _status = status;
+    _errorOffset = offset;
+    _text = StrView();
+    return _last = Error;
+}
+
+JsonReader::Event JsonReader::Open(bool object, size_t offset) {
+    if (_depth == maxDepth)
+        return Fail(tsErrorOverflow, offset);
+
+    uint64_t bit = uint64_t(1) << (_depth % 64);
+    if (object)
+        _stack[_depth / 64] |= bit;
+    else
+        _stack[_depth / 64] &= ~bit;
+    ++_depth;
+
+    _expect = object ? ExpectKeyOrClose : ExpectValueOrClose;
+    _text = StrView(_base + offset, 1);
+    return _last = object ? ObjectBegin : ArrayBegin;
+}
+
+JsonReader::Event JsonReader::Close(char c, size_t offset) {
+    bool object = c == '}';
+    if (!_depth || InObject() != object)
+        return Fail(tsErrorUnexpectedInput, offset);
+
+    --_depth;
+    AfterValue();
+    _text = StrView(_base + offset, 1);
+    return _last = object ? ObjectEnd : ArrayEnd;
+}
+
+JsonReader::Event JsonReader::Scalar(size_t offset) {
+    const char* p = _base + offset;
+    const char* end = _base + _length;
+
+    Event event;
+    const char* q;
+    if (*p == '-' || IsDigit(*p)) {
+        event = Number;
+        q = ScanNumber(p, end);
+        if (q == p)
+            return Fail(tsErrorExpectedNumber, offset);
+    }
+    else {
+        size_t available = static_cast<size_t>(end - p);
+        if (available >= 4 && !memcmp(p, "true", 4))
+            event = True, q = p + 4;
+        else if (available >= 5 && !memcmp(p, "false", 5))
+            event = False, q = p + 5;
+        else if (available >= 4 && !memcmp(p, "null", 4))
+            event = Null, q = p + 4;
+        else
+            return Fail(tsErrorUnexpectedInput, offset);
+    }
+    if (q < end && !IsDelimiter(*q))
+        return Fail(tsErrorUnexpectedInput, static_cast<size_t>(q - _base));
+
+    AfterValue();
+    _text = StrView(p, static_cast<size_t>(q - p));
+    return _last = event;
+}
+
+JsonReader::Event JsonReader::Next() {
+    if (_status != tsOk)
+        return Error;
+
+    for (;;) {
+        size_t offset = NextIndex();
+        if (offset == _length) {
+            if (_expect != ExpectEnd)
+                return Fail(tsErrorEndOfInput, offset);
+            _text = StrView();
+            return _last = End;
+        }
+
+        char c = _base[offset];
+        switch (_expect) {
+        case ExpectColon:
+            if (c != ':')
+                return Fail(tsErrorUnexpectedInput, offset);
+            _expect = ExpectValue;
+            continue;
+
+        case ExpectCommaOrClose:
+            if (c == ',') {
+                _expect = InObject() ? ExpectKey : ExpectValue;
+                continue;
+            }
+            if (c == '}' || c == ']')
+                return Close(c, offset);
+            return Fail(tsErrorUnexpectedInput, offset);
+
+        case ExpectEnd:
+            return Fail(tsErrorUnexpectedInput, offset);
+
+        case ExpectKeyOrClose:
+            if (c == '}')
+                return Close(c, offset);
+            // fall through
+        case ExpectKey:
+            if (c != '"')
+                return Fail(c == '}' ? tsErrorUnexpectedInput : tsErrorExpectedQuote, offset);
+            break;
+
+        case ExpectValueOrClose:
+            if (c == ']')
+                return Close(c, offset);
+            // fall through
+        case ExpectValue:
+            if (c == '{' || c == '[')
+                return Open(c == '{', offset);
+            if (c != '"')
+                return c == '}' || c == ']' || c == ':' || c == ',' ? Fail(tsErrorUnexpectedInput, offset)
+                                                                    : Scalar(offset);
+            break;
+        }
+
+        // a string or key; its closing quote is the next structural position
+        size_t close = NextIndex();
+        if (close == _length)
+            return Fail(tsErrorUnterminatedString, offset);
+        if (_base[close] != '"')
+            return Fail(tsErrorUnexpectedInput, close);
+
+        _text = StrView(_base + offset + 1, close - offset - 1);
+        if (_expect == ExpectKey || _expect == ExpectKeyOrClose) {
+            _expect = ExpectColon;
+            return _last = Key;
+        }
+        AfterValue();
+        return _last = String;
+    }
+}
+
+bool JsonReader::Skip() {
+    Assert(_last == ObjectBegin || _last == ArrayBegin);
+
+    size_t depth = 1;
+    for (;;) {
+        if (!_bits) {
+            if (_length - _block <= 64) {
+                Fail(tsErrorEndOfInput, _length);
+                return false;
+            }
+            _block += 64;
+            IndexBlock();
+            continue;
+        }
+
+        // If the rest of this block cannot close the container, take its
+        // bracket counts and move on without visiting each position.
+        uint64_t opens = _opens & _bits;
+        uint64_t closes = _closes & _bits;
+        size_t closeCount = static_cast<size_t>(PopCount64(closes));
+        if (closeCount < depth) {
+            depth += static_cast<size_t>(PopCount64(opens)) - closeCount;
+            _bits = 0;
+            continue;
+        }
+
+        while (_bits) {
+            uint64_t bit = _bits & (~_bits + 1);
+            _bits ^= bit;
+            if (opens & bit)
+                ++depth;
+            else if ((closes & bit) && !--depth) {
+                size_t offset = _block + static_cast<size_t>(CountTrailingZeros64(bit));
+                _last = InObject() ? ObjectEnd : ArrayEnd;
+                --_depth;
+                AfterValue();
+                _text = StrView(_base + offset, 1);
+                return true;
+            }
+        }
+    }
+}
+
+tsStatus JsonReader::GetInt32(int32_t& result) const {
+    Assert(_last == Number);
+    return DecodeNumber(_text, result, tsGetInt32Checked);
+}
+
+tsStatus JsonReader::GetUInt32(uint32_t& result) const {
+    Assert(_last == Number);
+    return DecodeNumber(_text, result, tsGetUInt32Checked);
+}
+
+tsStatus JsonReader::GetFloat(float& result) const {
+    Assert(_last == Number);
+    return DecodeNumber(_text, result, tsGetFloatChecked);
+}
+
+tsStatus JsonReader::GetDouble(double& result) const {
+    Assert(_last == Number);
+    return DecodeNumber(_text, result, tsGetDoubleChecked);
+}
+
+}} // lab::Text
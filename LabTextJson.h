@@ -0,0 +1,126 @@
+#pragma once
+
+/*
+ Pull reader for JSON documents.
+
+ License BSD-2 Clause.
+*/
+
+#include "LabText.h"
+
+namespace lab { namespace Text {
+
+// JsonReader walks a JSON document one event at a time. It builds no tree
+// and never allocates; Text returns views into the source.
+//
+//     JsonReader reader(json);
+//     JsonReader::Event e;
+//     while ((e = reader.Next()) != JsonReader::End && e != JsonReader::Error) {
+//         if (e == JsonReader::Key && reader.Text() == "metadata") {
+//             e = reader.Next();
+//             if (e == JsonReader::ObjectBegin || e == JsonReader::ArrayBegin)
+//                 reader.Skip();
+//         }
+//         ...
+//     }
+//     if (e == JsonReader::Error)
+//         Report(reader.Status(), reader.ErrorOffset());
+//
+// The source is indexed 64 bytes at a time: SSE2 compares mark quotes,
+// backslashes, brackets and separators, escaped quotes are discounted, and a
+// prefix xor over the quote positions masks out everything inside strings.
+// What remains is a bitmask of structural characters and value starts, which
+// Next consumes in order. Skip uses the bracket masks alone, passing over
+// whole blocks whose closing brackets cannot balance the open ones.
+//
+// The grammar is validated as events are pulled: separators, nesting, number
+// syntax, literals, and control characters inside strings. A skipped
+// container is only checked for string and bracket balance. Strings are
+// returned without their quotes and with escapes undecoded; UTF-8 is not
+// validated. Nesting deeper than maxDepth fails with tsErrorOverflow.
+
+class JsonReader {
+public:
+    enum Event : uint8_t {
+        End,            // the document is complete
+        Error,          // see Status and ErrorOffset
+        ObjectBegin,
+        ObjectEnd,
+        ArrayBegin,
+        ArrayEnd,
+        Key,
+        String,
+        Number,
+        True,
+        False,
+        Null,
+    };
+
+    enum { maxDepth = 256 };
+
+    explicit JsonReader(StrView json);
+
+    Event Next();
+
+    // Call after ObjectBegin or ArrayBegin to skip past the matching end, as
+    // if every event up to and including it had been read.
+    bool Skip();
+
+    // The text of the last Key, String, Number, True, False or Null.
+    StrView Text() const { return _text; }
+
+    // Decode the last Number with the LabText parsers. The whole number must
+    // be consumed, so GetInt32 rejects 1.5 with tsErrorUnexpectedInput.
+    tsStatus GetInt32(int32_t& result) const;
+    tsStatus GetUInt32(uint32_t& result) const;
+    tsStatus GetFloat(float& result) const;
+    tsStatus GetDouble(double& result) const;
+
+    // Containers currently open.
+    size_t   Depth() const { return _depth; }
+
+    tsStatus Status() const { return _status; }
+    size_t   ErrorOffset() const { return _errorOffset; }
+
+private:
+    enum Expect : uint8_t {
+        ExpectValue,
+        ExpectValueOrClose,
+        ExpectKey,
+        ExpectKeyOrClose,
+        ExpectColon,
+        ExpectCommaOrClose,
+        ExpectEnd,
+    };
+
+    void   IndexBlock();
+    size_t NextIndex();
+    Event  Fail(tsStatus status, size_t offset);
+    Event  Open(bool object, size_t offset);
+    Event  Close(char c, size_t offset);
+    Event  Scalar(size_t offset);
+    bool   InObject() const { return (_stack[(_depth - 1) / 64] >> ((_depth - 1) % 64)) & 1; }
+    void   AfterValue() { _expect = _depth ? ExpectCommaOrClose : ExpectEnd; }
+
+    const char* _base;
+    size_t      _length;
+
+    // structural index of the current block
+    size_t      _block = 0;         // offset of the block
+    uint64_t    _bits = 0;          // positions not yet consumed
+    uint64_t    _opens = 0;         // { and [ outside strings
+    uint64_t    _closes = 0;        // } and ] outside strings
+    uint64_t    _escapeCarry = 0;   // the block starts with an escaped byte
+    uint64_t    _stringCarry = 0;   // all ones if the block starts inside a string
+    uint64_t    _scalarCarry = 0;   // the previous block ended inside a number or literal
+
+    uint64_t    _stack[maxDepth / 64] = {};  // one bit per open container, set for objects
+    size_t      _depth = 0;
+    Expect      _expect = ExpectValue;
+    Event       _last = End;
+    StrView     _text;
+    tsStatus    _status = tsOk;
+    size_t      _errorOffset = 0;
+};
+
+}} // lab::Text
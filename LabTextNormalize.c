@@ -0,0 +1,304 @@
+#include "LabText.h"
+
+//------------------------------------------------------------------------------
+// IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+// Normalization before tokenizing, as one pass over the text. Blocks of 16
+// bytes that need nothing beyond a change of case are copied a vector at a
+// time; whitespace runs, line breaks, comments and literals are handled one
+// construct at a time by tsNormalizeStep. The output never outgrows the input
+// consumed, so dst may be the source itself.
+#include <assert.h>
+#define Assert assert
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define TS_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+    static inline int tsCountTrailingZeros32(uint32_t v) { unsigned long i; _BitScanForward(&i, v); return (int) i; }
+#elif defined(__GNUC__) || defined(__clang__)
+    static inline int tsCountTrailingZeros32(uint32_t v) { return __builtin_ctz(v); }
+#else
+    static inline int tsCountTrailingZeros32(uint32_t v)
+    {
+        int i = 0;
+        while (!(v & 1)) { v >>= 1; ++i; }
+        return i;
+    }
+#endif
+
+// as tsIsWhiteSpace, inlined for the per character loops
+static inline bool tsNormalizeIsWhiteSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+typedef struct tsNormalizer {
+    unsigned flags;
+    char*    dst;
+    char*    run;       // the output character standing for the current whitespace run
+    tsStatus status;
+} tsNormalizer;
+
+static inline char tsNormalizeCase(char c, unsigned flags)
+{
+    if ((flags & tsNormalizeLower) && c >= 'A' && c <= 'Z')
+        return (char) (c + ('a' - 'A'));
+    if ((flags & tsNormalizeUpper) && c >= 'a' && c <= 'z')
+        return (char) (c - ('a' - 'A'));
+    return c;
+}
+
+// A whitespace character, or a block comment, joins the current run when
+// collapsing. A run becomes one space, or one '\n' if it holds a line break.
+static inline void tsNormalizeWhiteSpace(tsNormalizer* n, char c)
+{
+    bool lineBreak = c == '\r' || c == '\n';
+    if (!(n->flags & tsNormalizeCollapseWhiteSpace))
+        *n->dst++ = c;
+    else if (!n->run)
+    {
+        n->run = n->dst;
+        *n->dst++ = lineBreak ? '\n' : ' ';
+    }
+    else if (lineBreak)
+        *n->run = '\n';
+}
+
+// Handles the character or construct at pCurr, and returns the position past it.
+static const char* tsNormalizeStep(tsNormalizer* n, const char* pCurr, const char* pEnd)
+{
+    unsigned flags = n->flags;
+    char c = *pCurr;
+
+    if ((flags & tsNormalizeStripComments) && c == '/' && pCurr + 1 < pEnd && (pCurr[1] == '/' || pCurr[1] == '*'))
+    {
+        tsStatus status;
+        const char* pPast = tsScanPastCPPCommentsChecked(pCurr, pEnd, &status);
+        if (status != tsOk && n->status == tsOk)
+            n->status = status;
+
+        if (pCurr[1] == '*')
+        {
+            tsNormalizeWhiteSpace(n, ' ');
+            return pPast;
+        }
+
+        // A line comment leaves its line break, which is processed as usual.
+        // The comment holds none, so any before pPast are the terminator.
+        while (pPast > pCurr + 2 && (pPast[-1] == '\r' || pPast[-1] == '\n'))
+            --pPast;
+        return pPast;
+    }
+
+    if ((flags & tsNormalizeStripComments) && (c == '"' || c == '\''))
+    {
+        // A literal must close on the line it opens, so that an apostrophe
+        // in prose does not hide the rest of the line.
+        const char* pClose = pCurr + 1;
+        while (pClose < pEnd && *pClose != c && *pClose != '\r' && *pClose != '\n')
+            pClose += *pClose == '\\' && pClose + 1 < pEnd && pClose[1] != '\r' && pClose[1] != '\n' ? 2 : 1;
+
+        if (pClose < pEnd && *pClose == c)
+        {
+            // Only the search for comments stops inside a literal. The other
+            // steps apply as they do elsewhere, so combining flags gives what
+            // separate passes would. A literal holds no line breaks, and
+            // starts and ends with a quote, so its whitespace runs collapse to
+            // a space and are its own. The locals keep the stores from
+            // reloading n.
+            char* dst = n->dst;
+            char* run = 0x0;
+            bool collapse = (flags & tsNormalizeCollapseWhiteSpace) != 0;
+            for (++pClose; pCurr < pClose; ++pCurr)
+            {
+                char d = *pCurr;
+                if (collapse && tsNormalizeIsWhiteSpace(d))
+                {
+                    if (!run)
+                    {
+                        run = dst;
+                        *dst++ = ' ';
+                    }
+                }
+                else
+                {
+                    *dst++ = tsNormalizeCase(d, flags);
+                    run = 0x0;
+                }
+            }
+            n->dst = dst;
+            n->run = 0x0;
+            return pCurr;
+        }
+    }
+
+    if ((flags & tsNormalizeCollapseWhiteSpace) && tsNormalizeIsWhiteSpace(c))
+    {
+        while (pCurr < pEnd && tsNormalizeIsWhiteSpace(*pCurr))
+            tsNormalizeWhiteSpace(n, *pCurr++);
+        return pCurr;
+    }
+
+    if ((flags & tsNormalizeLineBreaks) && (c == '\r' || c == '\n'))
+    {
+        // CRLF, LFCR, CR and LF, as tsScanForEndOfLine reads them
+        *n->dst++ = '\n';
+        ++pCurr;
+        if (pCurr < pEnd && (*pCurr == '\r' || *pCurr == '\n') && *pCurr != c)
+            ++pCurr;
+        return pCurr;
+    }
+
+    *n->dst++ = tsNormalizeCase(c, flags);
+    n->run = 0x0;
+    return pCurr + 1;
+}
+
+#ifdef TS_SSE2
+
+// Bytes at the start of a 16 byte block that can be copied with only a change
+// of case: those before the first that starts a construct tsNormalizeStep
+// must handle. next is the block one byte on, for the pairs.
+static inline uint32_t tsNormalizeSpecialMask(__m128i v, __m128i next, unsigned flags, bool inRun)
+{
+    __m128i special = _mm_setzero_si128();
+
+    if (flags & tsNormalizeCollapseWhiteSpace)
+    {
+        // a lone space or '\n' is already collapsed
+        __m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+        __m128i lf    = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+        __m128i ws    = _mm_or_si128(_mm_or_si128(space, lf),
+                                     _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+        __m128i wsNext = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(next, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(next, _mm_set1_epi8('\n'))),
+                                      _mm_or_si128(_mm_cmpeq_epi8(next, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(next, _mm_set1_epi8('\r'))));
+        special = _mm_or_si128(_mm_andnot_si128(_mm_or_si128(space, lf), ws), _mm_and_si128(ws, wsNext));
+        if (inRun)
+            special = _mm_or_si128(special, _mm_and_si128(ws, _mm_cvtsi32_si128(0xFF)));
+    }
+    else if (flags & tsNormalizeLineBreaks)
+    {
+        __m128i crNext = _mm_cmpeq_epi8(next, _mm_set1_epi8('\r'));
+        special = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')),
+                               _mm_and_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), crNext));
+    }
+
+    if (flags & tsNormalizeStripComments)
+    {
+        __m128i slashNext = _mm_or_si128(_mm_cmpeq_epi8(next, _mm_set1_epi8('/')), _mm_cmpeq_epi8(next, _mm_set1_epi8('*')));
+        __m128i comment   = _mm_and_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('/')), slashNext);
+        __m128i quote     = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\'')));
+        special = _mm_or_si128(special, _mm_or_si128(comment, quote));
+    }
+
+    return (uint32_t) _mm_movemask_epi8(special);
+}
+
+static inline __m128i tsNormalizeCaseVector(__m128i v, unsigned flags)
+{
+    // signed compares leave bytes >= 0x80 alone
+    if (flags & tsNormalizeLower)
+    {
+        __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+        return _mm_add_epi8(v, _mm_and_si128(upper, _mm_set1_epi8('a' - 'A')));
+    }
+    if (flags & tsNormalizeUpper)
+    {
+        __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('z' + 1)));
+        return _mm_sub_epi8(v, _mm_and_si128(lower, _mm_set1_epi8('a' - 'A')));
+    }
+    return v;
+}
+
+#endif
+
+size_t tsNormalizeChecked(
+    const char* pCurr, const char* pEnd,
+    char* dst,
+    unsigned flags,
+    tsStatus* status)
+{
+    Assert(pCurr && pEnd && pEnd >= pCurr && dst && status);
+    Assert(!((flags & tsNormalizeLower) && (flags & tsNormalizeUpper)));
+
+    tsNormalizer n;
+    n.flags = flags;
+    n.dst = dst;
+    n.run = 0x0;
+    n.status = tsOk;
+
+    while (pCurr < pEnd)
+    {
+#ifdef TS_SSE2
+        while (pEnd - pCurr >= 17)
+        {
+            __m128i v = _mm_loadu_si128((const __m128i*) pCurr);
+            __m128i next = _mm_loadu_si128((const __m128i*) (pCurr + 1));
+            uint32_t special = tsNormalizeSpecialMask(v, next, flags, n.run != 0x0);
+            int count = special ? tsCountTrailingZeros32(special) : 16;
+            if (count == 0)
+                break;
+
+            // A whole block may always be stored, since every byte it covers
+            // has been loaded. Part of one may not overwrite unread input.
+            v = tsNormalizeCaseVector(v, flags);
+            if (count == 16 || pCurr - n.dst >= 16 - count)
+                _mm_storeu_si128((__m128i*) n.dst, v);
+            else
+                for (int i = 0; i < count; ++i)
+                    n.dst[i] = tsNormalizeCase(pCurr[i], flags);
+            pCurr += count;
+            n.dst += count;
+            n.run = (flags & tsNormalizeCollapseWhiteSpace) && (n.dst[-1] == ' ' || n.dst[-1] == '\n') ? n.dst - 1 : 0x0;
+
+            if (count < 16)
+                break;
+        }
+        if (pCurr == pEnd)
+            break;
+#endif
+        pCurr = tsNormalizeStep(&n, pCurr, pEnd);
+    }
+
+    *status = n.status;
+    return (size_t) (n.dst - dst);
+}
+
+size_t tsNormalize(
+    const char* pCurr, const char* pEnd,
+    char* dst,
+    unsigned flags)
+{
+    tsStatus status;
+    return tsNormalizeChecked(pCurr, pEnd, dst, flags, &status);
+}
+
+size_t tsToLowerAscii(const char* pCurr, const char* pEnd, char* dst)
+{
+    return tsNormalize(pCurr, pEnd, dst, tsNormalizeLower);
+}
+
+size_t tsToUpperAscii(const char* pCurr, const char* pEnd, char* dst)
+{
+    return tsNormalize(pCurr, pEnd, dst, tsNormalizeUpper);
+}
+
+size_t tsCollapseWhiteSpace(const char* pCurr, const char* pEnd, char* dst)
+{
+    return tsNormalize(pCurr, pEnd, dst, tsNormalizeCollapseWhiteSpace);
+}
+
+size_t tsNormalizeNewlines(const char* pCurr, const char* pEnd, char* dst)
+{
+    return tsNormalize(pCurr, pEnd, dst, tsNormalizeLineBreaks);
+}
+
+size_t tsStripCppComments(const char* pCurr, const char* pEnd, char* dst)
+{
+    return tsNormalize(pCurr, pEnd, dst, tsNormalizeStripComments);
+}
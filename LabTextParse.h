@@ -0,0 +1,333 @@
+#pragma once
+
+/*
+ Parser combinators over the StrView API.
+
+ A grammar is an expression of small parser objects. Each parser has a type
+ determined by its structure, and is called as
+
+     bool parser(StrView& s) const;
+
+ On success it advances s past what it matched and returns true. On failure
+ it leaves s where it was and returns false. Captures may have been written
+ by a branch that later failed.
+
+ Everything is inline and non virtual, and nothing allocates, so a grammar
+ compiles down to the same calls a hand written parser would make.
+
+     StrView name;
+     int32_t count;
+     auto item = Lit("item") >> ws >> Token(name) >> ws >> Lit("=") >> Int32(count);
+     auto list = Lit("{") >> ws >> SeparatedBy(item, ws >> Lit(",") >> ws) >> ws >> Lit("}");
+     if (list(s)) ...
+
+ Primitives do not skip whitespace unless their underlying LabText function
+ does: Int32, Float and the other number captures, Token, and QuotedString
+ skip leading whitespace; Lit, Char, OneOf and Range do not. Use ws, which
+ skips whitespace and C++ comments, where the grammar allows it.
+
+ Requires C++17.
+
+ License BSD-2 Clause.
+*/
+
+#include "LabText.h"
+
+#include <type_traits>
+
+namespace lab { namespace Text { namespace Parse {
+
+// Every parser derives from Parser, which is what the operators below look for.
+struct Parser { };
+
+template<class P>
+using IsParser = std::enable_if_t<std::is_base_of<Parser, P>::value, int>;
+
+//----------------------------------------------------------------------------
+// Combinators
+
+template<class A, class B>
+struct Sequence : Parser {
+    A a;
+    B b;
+    constexpr Sequence(A a_, B b_) : a(a_), b(b_) { }
+
+    bool operator()(StrView& s) const {
+        StrView start = s;
+        if (a(s) && b(s))
+            return true;
+        s = start;
+        return false;
+    }
+};
+
+template<class A, class B>
+struct Alternative : Parser {
+    A a;
+    B b;
+    constexpr Alternative(A a_, B b_) : a(a_), b(b_) { }
+
+    bool operator()(StrView& s) const {
+        return a(s) || b(s);
+    }
+};
+
+// Matches p between min and max times; max of 0 means unbounded. Stops early
+// if p succeeds without consuming input, so it cannot loop forever.
+template<class P>
+struct Repeat : Parser {
+    P p;
+    size_t min, max;
+    constexpr Repeat(P p_, size_t min_, size_t max_) : p(p_), min(min_), max(max_) { }
+
+    bool operator()(StrView& s) const {
+        StrView start = s;
+        size_t n = 0;
+        while (max == 0 || n < max) {
+            const char* before = s.current;
+            if (!p(s))
+                break;
+            ++n;
+            if (s.current == before)
+                break;
+        }
+        if (n >= min)
+            return true;
+        s = start;
+        return false;
+    }
+};
+
+template<class P>
+struct Optional : Parser {
+    P p;
+    constexpr explicit Optional(P p_) : p(p_) { }
+
+    bool operator()(StrView& s) const {
+        p(s);
+        return true;
+    }
+};
+
+// Succeeds without consuming input if p would fail here.
+template<class P>
+struct Not : Parser {
+    P p;
+    constexpr explicit Not(P p_) : p(p_) { }
+
+    bool operator()(StrView& s) const {
+        StrView probe = s;
+        return !p(probe);
+    }
+};
+
+// Matches p and records the span it consumed.
+template<class P>
+struct Capture : Parser {
+    P p;
+    StrView& result;
+    Capture(P p_, StrView& result_) : p(p_), result(result_) { }
+
+    bool operator()(StrView& s) const {
+        const char* begin = s.current;
+        if (!p(s))
+            return false;
+        result = StrView(begin, static_cast<size_t>(s.current - begin));
+        return true;
+    }
+};
+
+template<class A, class B, IsParser<A> = 0, IsParser<B> = 0>
+constexpr Sequence<A, B> operator>>(A a, B b) { return Sequence<A, B>(a, b); }
+
+template<class A, class B, IsParser<A> = 0, IsParser<B> = 0>
+constexpr Alternative<A, B> operator|(A a, B b) { return Alternative<A, B>(a, b); }
+
+template<class P, IsParser<P> = 0>
+constexpr Repeat<P> ZeroOrMore(P p) { return Repeat<P>(p, 0, 0); }
+
+template<class P, IsParser<P> = 0>
+constexpr Repeat<P> OneOrMore(P p) { return Repeat<P>(p, 1, 0); }
+
+template<class P, IsParser<P> = 0>
+constexpr Repeat<P> Times(P p, size_t min, size_t max) { return Repeat<P>(p, min, max); }
+
+template<class P, IsParser<P> = 0>
+constexpr Optional<P> Maybe(P p) { return Optional<P>(p); }
+
+template<class P, IsParser<P> = 0>
+constexpr Not<P> Unless(P p) { return Not<P>(p); }
+
+template<class P, IsParser<P> = 0>
+Capture<P> Span(P p, StrView& result) { return Capture<P>(p, result); }
+
+// p, followed by any number of (separator p)
+template<class P, class S, IsParser<P> = 0, IsParser<S> = 0>
+constexpr auto SeparatedBy(P p, S separator) { return p >> ZeroOrMore(separator >> p); }
+
+//----------------------------------------------------------------------------
+// Matchers
+
+struct Literal : Parser {
+    const char* text;
+    size_t      length;
+    constexpr Literal(const char* text_, size_t length_) : text(text_), length(length_) { }
+
+    bool operator()(StrView& s) const {
+        if (s.length < length || memcmp(s.current, text, length))
+            return false;
+        s.current += length;
+        s.length -= length;
+        return true;
+    }
+};
+
+template<size_t N>
+constexpr Literal Lit(const char (&text)[N]) { return Literal(text, N - 1); }
+
+inline Literal Lit(StrView text) { return Literal(text.current, text.length); }
+
+// A set of bytes, built at compile time from a string or a range.
+struct CharSet : Parser {
+    uint64_t bits[4];
+
+    constexpr CharSet() : bits{0, 0, 0, 0} { }
+
+    constexpr CharSet& Add(unsigned char c) {
+        bits[c >> 6] |= uint64_t(1) << (c & 63);
+        return *this;
+    }
+
+    constexpr bool Contains(char c) const {
+        unsigned char u = static_cast<unsigned char>(c);
+        return (bits[u >> 6] >> (u & 63)) & 1;
+    }
+
+    bool operator()(StrView& s) const {
+        if (!s.length || !Contains(*s.current))
+            return false;
+        ++s.current;
+        --s.length;
+        return true;
+    }
+};
+
+constexpr CharSet OneOf(const char* chars) {
+    CharSet set;
+    for (; *chars; ++chars)
+        set.Add(static_cast<unsigned char>(*chars));
+    return set;
+}
+
+constexpr CharSet Range(char first, char last) {
+    CharSet set;
+    for (int c = static_cast<unsigned char>(first); c <= static_cast<unsigned char>(last); ++c)
+        set.Add(static_cast<unsigned char>(c));
+    return set;
+}
+
+constexpr CharSet Char(char c) {
+    return CharSet().Add(static_cast<unsigned char>(c));
+}
+
+constexpr CharSet operator+(CharSet a, CharSet b) {
+    CharSet set;
+    for (int i = 0; i < 4; ++i)
+        set.bits[i] = a.bits[i] | b.bits[i];
+    return set;
+}
+
+// Skips whitespace and C++ comments. Always succeeds.
+struct Whitespace : Parser {
+    bool operator()(StrView& s) const {
+        s = SkipCommentsAndWhitespace(s);
+        return true;
+    }
+};
+
+inline constexpr Whitespace ws;
+
+// Succeeds only at the end of input.
+struct End : Parser {
+    bool operator()(StrView& s) const { return s.length == 0; }
+};
+
+inline constexpr End endOfInput;
+
+//----------------------------------------------------------------------------
+// Captures
+
+// Wraps a checked LabText value parser: fn(StrView, T&, tsStatus&)
+template<class T, StrView (*Fn)(StrView, T&, tsStatus&)>
+struct ValueCapture : Parser {
+    T& result;
+    explicit ValueCapture(T& result_) : result(result_) { }
+
+    bool operator()(StrView& s) const {
+        tsStatus status;
+        StrView next = Fn(s, result, status);
+        if (status != tsOk)
+            return false;
+        s = next;
+        return true;
+    }
+};
+
+inline ValueCapture<int16_t,  GetInt16>  Int16 (int16_t&  result) { return ValueCapture<int16_t,  GetInt16>(result); }
+inline ValueCapture<int32_t,  GetInt32>  Int32 (int32_t&  result) { return ValueCapture<int32_t,  GetInt32>(result); }
+inline ValueCapture<uint32_t, GetUInt32> UInt32(uint32_t& result) { return ValueCapture<uint32_t, GetUInt32>(result); }
+inline ValueCapture<uint32_t, GetHex>    Hex   (uint32_t& result) { return ValueCapture<uint32_t, GetHex>(result); }
+inline ValueCapture<float,    GetFloat>  Float (float&    result) { return ValueCapture<float,    GetFloat>(result); }
+inline ValueCapture<double,   GetDouble> Double(double&   result) { return ValueCapture<double,   GetDouble>(result); }
+
+// A non empty GetTokenAlphaNumeric token
+struct TokenCapture : Parser {
+    StrView& result;
+    explicit TokenCapture(StrView& result_) : result(result_) { }
+
+    bool operator()(StrView& s) const {
+        StrView token;
+        StrView next = GetTokenAlphaNumeric(s, token);
+        if (!token.length)
+            return false;
+        result = token;
+        s = next;
+        return true;
+    }
+};
+
+inline TokenCapture Token(StrView& result) { return TokenCapture(result); }
+
+// A double quoted string whose opening quote is the next non whitespace
+// character; result excludes the quotes.
+struct StringCapture : Parser {
+    StrView& result;
+    bool     recognizeEscapes;
+    StringCapture(StrView& result_, bool recognizeEscapes_) : result(result_), recognizeEscapes(recognizeEscapes_) { }
+
+    bool operator()(StrView& s) const {
+        StrView next = ScanForNonWhiteSpace(s);
+        if (!next.length || *next.current != '"')
+            return false;
+        tsStatus status;
+        StrView str;
+        next = GetString(next, recognizeEscapes, str, status);
+        if (status != tsOk)
+            return false;
+        result = str;
+        s = next;
+        return true;
+    }
+};
+
+inline StringCapture QuotedString(StrView& result, bool recognizeEscapes = true) { return StringCapture(result, recognizeEscapes); }
+
+//----------------------------------------------------------------------------
+
+// Runs grammar over s, advancing s on success.
+template<class P, IsParser<P> = 0>
+inline bool Match(const P& grammar, StrView& s) {
+    return grammar(s);
+}
+
+}}} // lab::Text::Parse
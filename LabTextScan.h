@@ -0,0 +1,275 @@
+#pragma once
+
+/*
+ scanf style extraction of fixed layout records, with the format parsed at
+ compile time.
+
+     int32_t id;
+     double  value;
+     StrView name, message;
+     ScanResult r = Scan<"{i32} {f64} {tok} {str}">(line, id, value, name, message);
+     if (r.matched == 4) ...
+
+ Fields
+
+     {i16}  int16_t     GetInt16
+     {i32}  int32_t     GetInt32
+     {u32}  uint32_t    GetUInt32
+     {hex}  uint32_t    GetHex
+     {f32}  float       GetFloat
+     {f64}  double      GetDouble
+     {tok}  StrView     whitespace delimited, or up to the literal that
+                        follows it in the format; must not be empty
+     {str}  StrView     GetString; the next non whitespace must be a quote
+
+ Number fields skip leading whitespace, as their parsers do. A run of
+ whitespace in the format matches any amount of whitespace in the input,
+ including none. Any other character must match exactly; write {{ and }}
+ for literal braces.
+
+ The format is checked at compile time, and so are the number and types of
+ the arguments. Scan expands to a straight sequence of calls into the LabText
+ parsers. It stops at the first field or literal that does not match, and
+ returns the input from that point along with the number of fields stored.
+
+ Requires C++20.
+
+ License BSD-2 Clause.
+*/
+
+#include "LabText.h"
+
+#include <array>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace lab { namespace Text {
+
+struct ScanResult {
+    StrView rest;
+    int     matched;
+};
+
+namespace ScanDetail {
+
+template<size_t N>
+struct FormatString {
+    char text[N];
+
+    constexpr FormatString(const char (&str)[N]) {
+        for (size_t i = 0; i < N; ++i)
+            text[i] = str[i];
+    }
+
+    constexpr size_t size() const { return N - 1; }
+};
+
+enum class Field { I16, I32, U32, Hex, F32, F64, Token, String };
+
+struct Segment {
+    enum Kind { Literal, Space, Value } kind;
+    Field  field;
+    size_t index;       // argument index of a Value
+    size_t begin;       // Literal text within the format
+    size_t length;
+};
+
+// Not constexpr, so reaching one of these during constant evaluation fails
+// the build, and the compiler names the function in its diagnostic.
+void UnknownFieldInScanFormat();
+void UnmatchedBraceInScanFormat();
+
+constexpr bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+constexpr bool Equal(const char* a, size_t n, const char* b) {
+    for (size_t i = 0; i < n; ++i)
+        if (a[i] != b[i] || b[i] == '\0')
+            return false;
+    return b[n] == '\0';
+}
+
+constexpr Field FieldFromName(const char* name, size_t length) {
+    if (Equal(name, length, "i16")) return Field::I16;
+    if (Equal(name, length, "i32")) return Field::I32;
+    if (Equal(name, length, "u32")) return Field::U32;
+    if (Equal(name, length, "hex")) return Field::Hex;
+    if (Equal(name, length, "f32")) return Field::F32;
+    if (Equal(name, length, "f64")) return Field::F64;
+    if (Equal(name, length, "tok")) return Field::Token;
+    if (Equal(name, length, "str")) return Field::String;
+    UnknownFieldInScanFormat();
+    return Field::I32;
+}
+
+// Splits the format into segments; with out null, only counts them.
+template<size_t N>
+constexpr size_t ParseFormat(const FormatString<N>& format, Segment* out) {
+    const char* f = format.text;
+    const size_t n = format.size();
+    size_t count = 0;
+    size_t fields = 0;
+    size_t i = 0;
+    while (i < n) {
+        Segment seg{ Segment::Literal, Field::I32, 0, i, 0 };
+        if (IsSpace(f[i])) {
+            while (i < n && IsSpace(f[i]))
+                ++i;
+            seg.kind = Segment::Space;
+        }
+        else if (f[i] == '{' && i + 1 < n && f[i + 1] == '{') {
+            seg.length = 1;
+            i += 2;
+        }
+        else if (f[i] == '}') {
+            if (i + 1 >= n || f[i + 1] != '}')
+                UnmatchedBraceInScanFormat();
+            seg.length = 1;
+            i += 2;
+        }
+        else if (f[i] == '{') {
+            size_t close = i + 1;
+            while (close < n && f[close] != '}')
+                ++close;
+            if (close == n)
+                UnmatchedBraceInScanFormat();
+            seg.kind = Segment::Value;
+            seg.field = FieldFromName(f + i + 1, close - i - 1);
+            seg.index = fields++;
+            i = close + 1;
+        }
+        else {
+            while (i < n && !IsSpace(f[i]) && f[i] != '{' && f[i] != '}')
+                ++i;
+            seg.length = i - seg.begin;
+        }
+        if (out)
+            out[count] = seg;
+        ++count;
+    }
+    return count;
+}
+
+template<FormatString F>
+struct Format {
+    static constexpr size_t segmentCount = ParseFormat(F, nullptr);
+
+    static constexpr std::array<Segment, segmentCount> segments = [] {
+        std::array<Segment, segmentCount> result{};
+        ParseFormat(F, result.data());
+        return result;
+    }();
+
+    static constexpr size_t fieldCount = [] {
+        size_t count = 0;
+        for (const Segment& seg : segments)
+            count += seg.kind == Segment::Value;
+        return count;
+    }();
+};
+
+template<Field> struct FieldType;
+template<> struct FieldType<Field::I16>    { using type = int16_t; };
+template<> struct FieldType<Field::I32>    { using type = int32_t; };
+template<> struct FieldType<Field::U32>    { using type = uint32_t; };
+template<> struct FieldType<Field::Hex>    { using type = uint32_t; };
+template<> struct FieldType<Field::F32>    { using type = float; };
+template<> struct FieldType<Field::F64>    { using type = double; };
+template<> struct FieldType<Field::Token>  { using type = StrView; };
+template<> struct FieldType<Field::String> { using type = StrView; };
+
+// A whitespace delimited token that also ends at stop, the first character of
+// the literal after it in the format, so "{tok},{i32}" splits "a,1" in two.
+inline StrView ScanToken(StrView s, char stop, StrView& token) {
+    s = ScanForNonWhiteSpace(s);
+    const char* end = s.current + s.length;
+    const char* p = s.current;
+    while (p < end && *p != stop && !tsIsWhiteSpace(*p))
+        ++p;
+    token = StrView(s.current, static_cast<size_t>(p - s.current));
+    return { p, static_cast<size_t>(end - p) };
+}
+
+template<Field K, char Stop, class T>
+inline bool ScanField(StrView& s, T& result) {
+    static_assert(std::is_same<T, typename FieldType<K>::type>::value,
+                  "Scan argument type does not match its format field");
+
+    tsStatus status = tsOk;
+    StrView next;
+    if constexpr (K == Field::I16)      next = GetInt16(s, result, status);
+    else if constexpr (K == Field::I32) next = GetInt32(s, result, status);
+    else if constexpr (K == Field::U32) next = GetUInt32(s, result, status);
+    else if constexpr (K == Field::Hex) next = GetHex(s, result, status);
+    else if constexpr (K == Field::F32) next = GetFloat(s, result, status);
+    else if constexpr (K == Field::F64) next = GetDouble(s, result, status);
+    else if constexpr (K == Field::Token) {
+        StrView token;
+        if constexpr (Stop == '\0')
+            next = GetTokenWSDelimited(s, ' ', token);
+        else
+            next = ScanToken(s, Stop, token);
+        if (!token.length)
+            return false;
+        result = token;
+    }
+    else {
+        StrView str = ScanForNonWhiteSpace(s);
+        if (!str.length || *str.current != '"')
+            return false;
+        next = GetString(str, true, str, status);
+        if (status == tsOk)
+            result = str;
+    }
+
+    if (status != tsOk)
+        return false;
+    s = next;
+    return true;
+}
+
+template<FormatString F, size_t I, class Args>
+inline bool ScanStep(StrView& s, int& matched, Args& args) {
+    constexpr Segment seg = Format<F>::segments[I];
+    if constexpr (seg.kind == Segment::Literal) {
+        if (s.length < seg.length || memcmp(s.current, F.text + seg.begin, seg.length))
+            return false;
+        s.current += seg.length;
+        s.length -= seg.length;
+        return true;
+    }
+    else if constexpr (seg.kind == Segment::Space) {
+        s = ScanForNonWhiteSpace(s);
+        return true;
+    }
+    else {
+        constexpr bool literalNext = I + 1 < Format<F>::segmentCount &&
+                                     Format<F>::segments[I + 1].kind == Segment::Literal;
+        constexpr char stop = literalNext ? F.text[Format<F>::segments[I + 1].begin] : '\0';
+        if (!ScanField<seg.field, stop>(s, std::get<seg.index>(args)))
+            return false;
+        ++matched;
+        return true;
+    }
+}
+
+template<FormatString F, class Args, size_t... I>
+inline ScanResult ScanAll(StrView s, Args& args, std::index_sequence<I...>) {
+    int matched = 0;
+    (ScanStep<F, I>(s, matched, args) && ...);
+    return { s, matched };
+}
+
+} // ScanDetail
+
+template<ScanDetail::FormatString F, class... Args>
+inline ScanResult Scan(StrView s, Args&... args) {
+    using Format = ScanDetail::Format<F>;
+    static_assert(sizeof...(Args) == Format::fieldCount,
+                  "Scan needs one argument per format field");
+
+    auto refs = std::tie(args...);
+    return ScanDetail::ScanAll<F>(s, refs, std::make_index_sequence<Format::segmentCount>());
+}
+
+}} // lab::Text
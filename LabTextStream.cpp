@@ -0,0 +1,194 @@
+#include "LabTextStream.h"
+
+//------------------------------------------------------------------------------
+// IMPLEMENTATION
+//------------------------------------------------------------------------------
+
+namespace lab { namespace Text {
+
+namespace {
+
+bool IsBreak(char c) {
+    return c == '\n' || c == '\r';
+}
+
+// A read is cut only where a line break is followed by something else, so a
+// run of breaks is never split, whichever of its CRLF and LFCR pairs
+// tsScanForEndOfLine would join.
+
+// Returns the last cut after begin, or begin if there is none.
+const char* LastCut(const char* begin, const char* end) {
+    for (const char* p = end - 1; p > begin; --p)
+        if (IsBreak(p[-1]) && !IsBreak(*p))
+            return p;
+    return begin;
+}
+
+// Returns the first cut at or after begin, given the byte before it.
+const char* FirstCut(const char* begin, const char* end, char before) {
+    for (const char* p = begin; p < end; before = *p++)
+        if (IsBreak(before) && !IsBreak(*p))
+            return p;
+    return end;
+}
+
+} // anon
+
+ChunkReader::ChunkReader(tsReadFn read, void* user, size_t chunkSize, int buffers)
+: _read(read)
+, _user(user)
+, _slots(buffers < 1 ? 1 : static_cast<size_t>(buffers)) {
+    for (Slot& slot : _slots) {
+        slot.data.resize(chunkSize ? chunkSize : 1);
+        slot.length = 0;
+    }
+
+    if (_slots.size() > 1)
+        _producer = std::thread(&ChunkReader::Produce, this);
+}
+
+ChunkReader::~ChunkReader() {
+    if (_producer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _emptied.notify_one();
+        _producer.join();
+    }
+}
+
+void ChunkReader::Produce() {
+    const size_t slots = _slots.size();
+    for (;;) {
+        size_t slot;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _emptied.wait(lock, [&] { return _stop || _count < slots; });
+            if (_stop)
+                return;
+            slot = _tail;
+        }
+
+        // the slot belongs to this thread until it is published below
+        Slot& s = _slots[slot];
+        size_t length = 0;
+        try {
+            length = _read(_user, s.data.data(), s.data.size());
+        }
+        catch (...) {
+            // handed to the consumer; an exception must not escape the thread
+            std::lock_guard<std::mutex> lock(_mutex);
+            _error = std::current_exception();
+        }
+        s.length = length;
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (length == 0)
+                _eof = true;
+            else {
+                _tail = (_tail + 1) % slots;
+                ++_count;
+            }
+        }
+        _filled.notify_one();
+
+        if (length == 0)
+            return;
+    }
+}
+
+bool ChunkReader::Acquire(StrView& raw) {
+    if (!_producer.joinable()) {
+        if (_eof)
+            return false;
+        Slot& s = _slots[0];
+        s.length = _read(_user, s.data.data(), s.data.size());
+        if (s.length == 0) {
+            _eof = true;
+            return false;
+        }
+        raw = StrView(s.data.data(), s.length);
+        _holding = true;
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _filled.wait(lock, [&] { return _count > 0 || _eof; });
+    if (_count == 0) {
+        if (_error)
+            std::rethrow_exception(_error);
+        return false;
+    }
+
+    const Slot& s = _slots[_head];
+    raw = StrView(s.data.data(), s.length);
+    _holding = true;
+    return true;
+}
+
+void ChunkReader::Release() {
+    _holding = false;
+    if (!_producer.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _head = (_head + 1) % _slots.size();
+        --_count;
+    }
+    _emptied.notify_one();
+}
+
+bool ChunkReader::Next(StrView& chunk) {
+    for (;;) {
+        if (!IsEmpty(_body)) {
+            chunk = _body;
+            _body = StrView();
+            return true;
+        }
+
+        if (_holding)
+            Release();
+
+        StrView raw;
+        if (!Acquire(raw)) {
+            if (_carry.empty())
+                return false;
+
+            _stitch.swap(_carry);
+            _carry.clear();
+            chunk = StrView(_stitch.data(), _stitch.size());
+            return true;
+        }
+
+        const char* begin = raw.current;
+        const char* end = raw.current + raw.length;
+        const char* last = LastCut(begin, end);
+
+        if (last == begin) {
+            // no complete line yet
+            _carry.insert(_carry.end(), begin, end);
+            continue;
+        }
+
+        const char* body = begin;
+        bool stitched = !_carry.empty();
+        if (stitched) {
+            body = FirstCut(begin, last, _carry.back());
+            _stitch.assign(_carry.begin(), _carry.end());
+            _stitch.insert(_stitch.end(), begin, body);
+        }
+
+        _body = StrView(body, static_cast<size_t>(last - body));
+        _carry.assign(last, end);
+
+        if (stitched) {
+            chunk = StrView(_stitch.data(), _stitch.size());
+            return true;
+        }
+    }
+}
+
+}} // lab::Text
@@ -0,0 +1,90 @@
+#pragma once
+
+/*
+ Chunked reading for inputs that are too large, or arrive too slowly, to be
+ held in memory whole.
+
+ License BSD-2 Clause.
+*/
+
+#include "LabText.h"
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lab { namespace Text {
+
+// ChunkReader delivers its input as a sequence of StrViews, each ending on a
+// line boundary, so a chunk can be scanned with the StrView API without
+// worrying about a token or line being cut in two. A line that straddles two
+// reads is stitched together and delivered as a chunk of its own; the final
+// chunk may lack a trailing line break.
+//
+// Chunks end after the last line break of a read that is followed by another
+// byte of the same read, other than '\r' or '\n'. A run of line breaks is
+// therefore never split, so CRLF and LFCR pairs stay whole, and a read that
+// ends in a line break holds it back until the next read shows what follows.
+//
+// With two or more buffers, reads are issued on a background thread into a
+// ring of reusable buffers, so the next read proceeds while the current
+// chunk is being parsed. With one buffer, Next reads synchronously.
+//
+// An exception thrown by the read function is rethrown from Next, on the
+// consumer's thread, once the chunks read before it have been delivered.
+//
+//     FILE* f = fopen(path, "rb");
+//     ChunkReader reader(tsReadFile, f);
+//     StrView chunk;
+//     while (reader.Next(chunk))
+//         while (!IsEmpty(chunk))
+//             chunk = ParseRecord(chunk);
+//
+// A chunk remains valid until the following call to Next.
+
+class ChunkReader {
+public:
+    ChunkReader(tsReadFn read, void* user, size_t chunkSize = 1 << 20, int buffers = 3);
+    ~ChunkReader();
+
+    ChunkReader(const ChunkReader&) = delete;
+    ChunkReader& operator=(const ChunkReader&) = delete;
+
+    bool Next(StrView& chunk);
+
+private:
+    struct Slot {
+        std::vector<char> data;
+        size_t            length;
+    };
+
+    bool Acquire(StrView& raw);
+    void Release();
+    void Produce();
+
+    tsReadFn                _read;
+    void*                   _user;
+    std::vector<Slot>       _slots;
+
+    // ring state, guarded by _mutex when a producer thread is running
+    std::mutex              _mutex;
+    std::condition_variable _filled;
+    std::condition_variable _emptied;
+    size_t                  _head = 0;      // next slot the consumer takes
+    size_t                  _tail = 0;      // next slot the producer fills
+    size_t                  _count = 0;     // filled slots not yet released
+    bool                    _eof = false;
+    bool                    _stop = false;
+    std::exception_ptr      _error;         // thrown by _read on the producer
+    std::thread             _producer;
+
+    // consumer state
+    bool                    _holding = false;
+    StrView                 _body;          // line-aligned remainder of the held slot
+    std::vector<char>       _carry;         // partial line awaiting the next read
+    std::vector<char>       _stitch;        // carry joined with the head of a read
+};
+
+}} // lab::Text
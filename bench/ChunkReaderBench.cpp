@@ -0,0 +1,143 @@
+/*
+ ChunkReaderBench: measures how much of the I/O time ChunkReader hides
+ behind parsing.
+
+ The input is a generated table of integers, read through a tsReadFn that
+ sleeps to model a device of fixed bandwidth, so the read waits rather than
+ computes, as it does on a disk or a socket. Each chunk is parsed with
+ tsGetInt32. With one buffer the reads and the parse take turns, and the run
+ costs io + parse; with a ring of buffers the reads overlap the parse, and
+ the run should approach max(io, parse).
+
+     ChunkReaderBench [MiB] [io MB/s]
+
+ By default the device bandwidth is set to the measured parse rate, where
+ overlap matters most: the sequential run takes twice as long as either
+ side alone.
+
+ License BSD-2 Clause.
+*/
+
+#include "LabTextStream.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+using namespace lab::Text;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double Seconds(Clock::time_point since) {
+    return std::chrono::duration<double>(Clock::now() - since).count();
+}
+
+struct Device {
+    const char* data;
+    size_t      length;
+    size_t      offset;
+    double      bytesPerSecond;     // 0 for memory speed
+};
+
+size_t ReadDevice(void* user, char* dst, size_t capacity) {
+    Device* d = static_cast<Device*>(user);
+    size_t n = d->length - d->offset;
+    if (n > capacity)
+        n = capacity;
+    memcpy(dst, d->data + d->offset, n);
+    d->offset += n;
+    if (d->bytesPerSecond > 0 && n > 0)
+        std::this_thread::sleep_for(std::chrono::duration<double>(n / d->bytesPerSecond));
+    return n;
+}
+
+int64_t Parse(StrView s) {
+    int64_t sum = 0;
+    while (!IsEmpty(s)) {
+        int32_t value = 0;
+        StrView next = GetInt32(s, value);
+        if (next.current == s.current)
+            next = StrView(s.current + 1, s.length - 1);   // trailing whitespace
+        sum += value;
+        s = next;
+    }
+    return sum;
+}
+
+std::string Generate(size_t bytes) {
+    std::string text;
+    text.reserve(bytes + 64);
+    uint32_t x = 2463534242u;
+    char field[16];
+    while (text.size() < bytes) {
+        for (int i = 0; i < 8; ++i) {
+            x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+            int n = snprintf(field, sizeof(field), "%d ", static_cast<int32_t>(x) >> (x & 15));
+            text.append(field, static_cast<size_t>(n));
+        }
+        text.back() = '\n';
+    }
+    return text;
+}
+
+// Reads the whole device through a ChunkReader, parsing each chunk if asked.
+double Run(const std::string& text, double bytesPerSecond, int buffers, bool parse, int64_t& sum) {
+    Device device = { text.data(), text.size(), 0, bytesPerSecond };
+    Clock::time_point start = Clock::now();
+    ChunkReader reader(ReadDevice, &device, 1 << 20, buffers);
+    StrView chunk;
+    sum = 0;
+    while (reader.Next(chunk))
+        if (parse)
+            sum += Parse(chunk);
+    return Seconds(start);
+}
+
+void Report(const char* name, double seconds, size_t bytes) {
+    printf("%-24s %8.3f s %9.1f MB/s\n", name, seconds, bytes / seconds / 1e6);
+}
+
+} // anon
+
+int main(int argc, char** argv) {
+    size_t mib = argc > 1 ? strtoul(argv[1], nullptr, 10) : 64;
+    double ioRate = argc > 2 ? strtod(argv[2], nullptr) * 1e6 : 0;
+    if (mib == 0)
+        mib = 1;
+
+    std::string text = Generate(mib << 20);
+    const size_t bytes = text.size();
+
+    int64_t expected = 0;
+    Clock::time_point start = Clock::now();
+    expected = Parse(StrView(text.data(), text.size()));
+    double parse = Seconds(start);
+    if (ioRate <= 0)
+        ioRate = bytes / parse;
+
+    int64_t sum = 0;
+    double io = Run(text, ioRate, 3, false, sum);
+    double sequential = Run(text, ioRate, 1, true, sum);
+    bool ok = sum == expected;
+    double overlapped = Run(text, ioRate, 3, true, sum);
+    ok = ok && sum == expected;
+
+    printf("%zu bytes, device %.1f MB/s\n", bytes, ioRate / 1e6);
+    Report("parse only", parse, bytes);
+    Report("io only", io, bytes);
+    Report("io + parse", io + parse, bytes);
+    Report("max(io, parse)", io > parse ? io : parse, bytes);
+    Report("1 buffer", sequential, bytes);
+    Report("3 buffers", overlapped, bytes);
+
+    if (!ok) {
+        fprintf(stderr, "checksum mismatch\n");
+        return 1;
+    }
+    return 0;
+}